@@ -0,0 +1,125 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/adc.h"
+#include "include/event.h"
+#include "include/dma.h"
+#include "include/uart.h"
+#include "include/trace.h"
+#include <msp430.h>
+
+#if defined(UART_RX_FRAME_MODE) || defined(TRACE_ENABLE)
+#error "adc triggers the conversions with TA0, which is already in use"
+#endif
+
+#define TIMER_PERIOD (32768UL / ADC_SAMPLE_HZ)
+
+typedef char sample_rate_check[(TIMER_PERIOD >= 2 && 32768UL % ADC_SAMPLE_HZ == 0) ? 1 : -1];
+
+static u16 buffer[2][ADC_BLOCK_SIZE];
+// The block the DMA is filling and the one that is ready
+static volatile u8 filling;
+static volatile u8 ready_block;
+static volatile bool ready;
+static u16 overruns;
+
+/******************************* HARDWARE ***********************************/
+static inline void dma_set_address(volatile void *reg, const volatile void *address)
+{
+	__data16_write_addr((unsigned short)(uintptr_t)reg, (unsigned long)(uintptr_t)address);
+}
+
+/* Repeated single transfers: when the size runs out, the addresses and the
+ * size are reloaded from the registers. So writing DMA2DA while a block is
+ * being filled sets where the next block goes. */
+static inline void dma_start(void)
+{
+	dma_set_address(&DMA2SA, &ADC12MEM0);
+	dma_set_address(&DMA2DA, buffer[0]);
+	DMA2SZ = ADC_BLOCK_SIZE;
+	DMA2CTL = DMADT_4 | DMADSTINCR_3 | DMASRCINCR_0 | DMAIE | DMAEN;
+	dma_set_address(&DMA2DA, buffer[1]);
+}
+
+static inline void dma_stop(void)
+{
+	DMA2CTL &= ~(DMAEN | DMAIE | DMAIFG);
+}
+
+static inline void adc12_init(void)
+{
+	ADC12CTL0 = ADC_SAMPLE_HOLD | ADC12ON;
+	// Repeated single channel, every rising edge of TA0.1 starts a conversion
+	ADC12CTL1 = ADC12SHS_1 | ADC12SHP | ADC12SSEL_0 | ADC12CONSEQ_2;
+	ADC12CTL2 = ADC12RES_2;
+	ADC12MCTL0 = ADC_REFERENCE | ADC_INPUT;
+	ADC12CTL0 |= ADC12ENC;
+}
+
+static inline void timer_start(void)
+{
+	TA0CCR0 = TIMER_PERIOD - 1;
+	TA0CCR1 = TIMER_PERIOD / 2;
+	TA0CCTL1 = OUTMOD_3;
+	TA0CTL = TASSEL_1 | MC_1 | TACLR;
+}
+
+static inline void timer_stop(void)
+{
+	TA0CTL = TASSEL_1;
+}
+/****************************************************************************/
+
+// Called from the DMA ISR at the end of each block
+static void block_end(void)
+{
+	u8 full = filling;
+
+	// The DMA has reloaded and fills the other block now
+	filling = full ^ 1;
+	dma_set_address(&DMA2DA, buffer[full]);
+
+	if (ready)
+		++overruns;
+	ready_block = full;
+	ready = True;
+	event_set_traced(EVENT_ADC);
+}
+
+void adc_init(void)
+{
+	adc12_init();
+	DMACTL1 = (DMACTL1 & 0xFF00) | ADC_DMA_TRIGGER;
+	dma_register(2, block_end);
+	ready = False;
+	overruns = 0;
+}
+
+void adc_start(void)
+{
+	ready = False;
+	filling = 0;
+	dma_start();
+	timer_start();
+}
+
+void adc_stop(void)
+{
+	timer_stop();
+	dma_stop();
+}
+
+const u16 *adc_block(void)
+{
+	return ready ? buffer[ready_block] : Null;
+}
+
+void adc_release(void)
+{
+	ready = False;
+}
+
+u16 adc_overruns(void)
+{
+	return overruns;
+}
@@ -0,0 +1,243 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/ao.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+
+#define QUEUE_MASK (AO_QUEUE_SIZE - 1)
+typedef char queue_size_check[(AO_QUEUE_SIZE & QUEUE_MASK) ? -1 : 1];
+typedef char depth_check[(AO_MAX_DEPTH <= 8) ? 1 : -1];
+
+static ao_t *object[AO_MAX_OBJECTS];
+static uint object_count;
+
+static u16 ao_timer(int id, u16 latency)
+{
+	ao_t *ao = object[id / AO_MAX_DEPTH];
+	uint depth = id % AO_MAX_DEPTH;
+
+	// The owner may have been exited after the timer was deleted
+	if (Null != ao->timer_owner[depth]) {
+		ao->expired |= 1 << depth;
+		event_set(EVENT_AO);
+	}
+	return 0;
+}
+
+// Number of ancestors, also the index of the state's timer
+static uint state_depth(const ao_state_t *state)
+{
+	uint depth = 0;
+
+	while (Null != (state = state->parent))
+		++depth;
+	assert(depth < AO_MAX_DEPTH);
+	return depth;
+}
+
+static inline int timer_id(const ao_t *ao, uint depth)
+{
+	return ao->index * AO_MAX_DEPTH + depth;
+}
+
+static void state_enter(ao_t *ao, const ao_state_t *state)
+{
+	uint depth;
+
+	if (Null != state->entry)
+		state->entry(ao);
+	if (state->timeout_ms) {
+		depth = state_depth(state);
+		ao->timer_owner[depth] = state;
+		systimer_renew_task(state->timeout_ms, ao_timer, timer_id(ao, depth));
+	}
+}
+
+static void state_exit(ao_t *ao, const ao_state_t *state)
+{
+	uint depth;
+
+	if (Null != state->exit)
+		state->exit(ao);
+	if (state->timeout_ms) {
+		depth = state_depth(state);
+		if (ao->timer_owner[depth] == state) {
+			ao->timer_owner[depth] = Null;
+			systimer_delete_task(ao_timer, timer_id(ao, depth));
+		}
+		// An expiry that is not dispatched yet is not delivered after the exit
+		ao->expired &= ~(1 << depth);
+	}
+}
+
+bool ao_in_state(const ao_t *ao, const ao_state_t *state)
+{
+	const ao_state_t *s;
+
+	for (s = ao->state; Null != s; s = s->parent) {
+		if (s == state)
+			return True;
+	}
+	return False;
+}
+
+// Enters the states below lca down to target, then its initial substates
+static void enter_down(ao_t *ao, const ao_state_t *lca, const ao_state_t *target)
+{
+	const ao_state_t *path[AO_MAX_DEPTH];
+	const ao_state_t *s;
+	int depth = 0;
+
+	for (s = target; s != lca; s = s->parent) {
+		assert(depth < AO_MAX_DEPTH);
+		path[depth++] = s;
+	}
+	while (depth)
+		state_enter(ao, path[--depth]);
+
+	while (Null != target->initial) {
+		target = target->initial;
+		state_enter(ao, target);
+	}
+	ao->state = target;
+}
+
+static void transition(ao_t *ao, const ao_transition_t *tran)
+{
+	const ao_state_t *target = tran->target;
+	const ao_state_t *lca;
+	const ao_state_t *s;
+
+	if (Null == target) {
+		if (Null != tran->action)
+			tran->action(ao);
+		return;
+	}
+
+	// The innermost state that contains both, a transition to the current
+	// state or to one of its ancestors leaves and re-enters the target
+	for (lca = target; Null != lca && !ao_in_state(ao, lca); lca = lca->parent)
+		;
+	if (lca == target)
+		lca = target->parent;
+
+	for (s = ao->state; s != lca; s = s->parent)
+		state_exit(ao, s);
+	if (Null != tran->action)
+		tran->action(ao);
+	enter_down(ao, lca, target);
+}
+
+// Tries the state first, then its parents
+static void dispatch(ao_t *ao, const ao_state_t *state, u8 signal)
+{
+	const ao_transition_t *tran;
+	const ao_state_t *s;
+
+	if (signal >= ao->signals)
+		return;
+
+	for (s = state; Null != s; s = s->parent) {
+		if (Null == s->table)
+			continue;
+		tran = &s->table[signal];
+		if (Null != tran->action || Null != tran->target) {
+			transition(ao, tran);
+			return;
+		}
+	}
+	// Not handled by any state, ignored
+}
+
+static inline bool queue_empty(const ao_t *ao)
+{
+	return ao->head == ao->tail;
+}
+
+// The timeouts go to the states that own the timers, the innermost first
+static void timeouts(ao_t *ao)
+{
+	const ao_state_t *owner;
+	uint depth = AO_MAX_DEPTH;
+
+	while (ao->expired && depth--) {
+		if (ao->expired & (1 << depth)) {
+			ao->expired &= ~(1 << depth);
+			owner = ao->timer_owner[depth];
+			ao->timer_owner[depth] = Null;
+			dispatch(ao, owner, AO_SIG_TIMEOUT);
+		}
+	}
+}
+
+static void ao_run(void)
+{
+	bool pending = False;
+	ao_t *ao;
+	uint i;
+	u8 signal;
+
+	for (i = 0; i < object_count; i++) {
+		ao = object[i];
+		while (!queue_empty(ao)) {
+			signal = ao->queue[ao->tail & QUEUE_MASK];
+			++ao->tail;
+			dispatch(ao, ao->state, signal);
+		}
+		timeouts(ao);
+	}
+
+	// Posts to an object that was already run, let the other events in first
+	for (i = 0; i < object_count; i++) {
+		if (!queue_empty(object[i]) || object[i]->expired)
+			pending = True;
+	}
+	if (pending)
+		event_set(EVENT_AO);
+}
+
+void ao_init(void)
+{
+	object_count = 0;
+	event_register(EVENT_AO, ao_run);
+}
+
+bool ao_start(ao_t *ao, const ao_state_t *initial, u8 signals)
+{
+	uint i;
+
+	if (object_count >= AO_MAX_OBJECTS)
+		return False;
+
+	ao->index = object_count;
+	ao->signals = signals;
+	ao->state = Null;
+	for (i = 0; i < AO_MAX_DEPTH; i++)
+		ao->timer_owner[i] = Null;
+	ao->expired = 0;
+	ao->tail = ao->head;
+	ao->overrun = 0;
+	object[object_count++] = ao;
+
+	enter_down(ao, Null, initial);
+	return True;
+}
+
+bool ao_post(ao_t *ao, u8 signal)
+{
+	bool posted = False;
+
+	_uninterrupted(
+		if ((u8)(ao->head - ao->tail) < AO_QUEUE_SIZE) {
+			ao->queue[ao->head & QUEUE_MASK] = signal;
+			++ao->head;
+			posted = True;
+		} else {
+			++ao->overrun;
+		}
+	);
+	if (posted)
+		event_set_traced(EVENT_AO);
+	return posted;
+}
@@ -0,0 +1,233 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/capture.h"
+#include "include/event.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#define QUEUE_MASK (CAPTURE_QUEUE_SIZE - 1)
+typedef char queue_size_check[(CAPTURE_QUEUE_SIZE & QUEUE_MASK) ? -1 : 1];
+
+typedef struct edge_queue {
+	capture_edge_t edge[CAPTURE_QUEUE_SIZE];
+	volatile u8    head;
+	volatile u8    tail;
+	u16            overrun;
+} edge_queue_t;
+
+static edge_queue_t queue[CAPTURE_INPUT_COUNT];
+
+/* The change of the position for the index (previous state << 2 | state),
+ * 2 marks an impossible transition */
+static const s8 quad_table[16] = {
+	 0, -1, +1,  2,
+	+1,  0,  2, -1,
+	-1,  2,  0, +1,
+	 2, +1, -1,  0
+};
+
+/******************************* HARDWARE ***********************************/
+// The channel registers of CCR1 and above are contiguous
+#define CAPTURE_CCTL(input) ((&TB0CCTL1)[input])
+#define CAPTURE_CCR(input)  ((&TB0CCR1)[input])
+
+static void timer_init(void)
+{
+	uint i;
+
+	TB0CTL = CAPTURE_CLOCK | TBCLR;
+	// One edge at a time, the opposite of the pin state: the ISR knows the edge
+	for (i = 0; i < CAPTURE_INPUT_COUNT; i++) {
+		CAPTURE_CCTL(i) = CCIS_0 | SCS | CAP;
+		CAPTURE_CCTL(i) |= ((CAPTURE_CCTL(i) & CCI) ? CM_2 : CM_1) | CCIE;
+	}
+	TB0CTL = CAPTURE_CLOCK | MC__CONTINUOUS;
+}
+
+static inline u8 pin_state(uint input)
+{
+	return (CAPTURE_CCTL(input) & CCI) ? 1 : 0;
+}
+
+// The state after the edge that the channel is waiting for
+static inline u8 capture_state(uint input)
+{
+	return (CAPTURE_CCTL(input) & CM_3) == CM_1 ? 1 : 0;
+}
+/****************************************************************************/
+
+static inline bool queue_empty(const edge_queue_t *q)
+{
+	return q->head == q->tail;
+}
+
+static inline const capture_edge_t *queue_front(const edge_queue_t *q)
+{
+	return &q->edge[q->tail & QUEUE_MASK];
+}
+
+static inline void queue_edge(edge_queue_t *q, u16 time, u8 state)
+{
+	u8 head = q->head;
+
+	if ((u8)(head - q->tail) < CAPTURE_QUEUE_SIZE) {
+		q->edge[head & QUEUE_MASK].time = time;
+		q->edge[head & QUEUE_MASK].state = state;
+		q->head = head + 1;
+	} else {
+		++q->overrun;
+	}
+}
+
+void capture_init(void)
+{
+	uint i;
+
+	for (i = 0; i < CAPTURE_INPUT_COUNT; i++) {
+		queue[i].tail = queue[i].head;
+		queue[i].overrun = 0;
+	}
+	timer_init();
+}
+
+uint capture_read(uint input, capture_edge_t *edges, uint max)
+{
+	edge_queue_t *q = &queue[input];
+	uint count = 0;
+
+	assert(input < CAPTURE_INPUT_COUNT);
+	while (count < max && !queue_empty(q)) {
+		edges[count++] = *queue_front(q);
+		++q->tail;
+	}
+	return count;
+}
+
+u16 capture_overruns(uint input)
+{
+	return queue[input].overrun;
+}
+
+void capture_quad_init(capture_quad_t *quad, uint input_a, uint input_b)
+{
+	quad->a = input_a;
+	quad->b = input_b;
+	quad->position = 0;
+	quad->errors = 0;
+	quad->state = pin_state(input_a) << 1 | pin_state(input_b);
+	// The edges before now are not relative to this state
+	queue[input_a].tail = queue[input_a].head;
+	queue[input_b].tail = queue[input_b].head;
+}
+
+void capture_quad_update(capture_quad_t *quad)
+{
+	edge_queue_t *qa = &queue[quad->a];
+	edge_queue_t *qb = &queue[quad->b];
+	const capture_edge_t *edge;
+	u8 state;
+	s8 step;
+
+	for (;;) {
+		// Merge the two queues in time order
+		if (!queue_empty(qa) && (queue_empty(qb)
+		    || (s16)(queue_front(qa)->time - queue_front(qb)->time) <= 0)) {
+			edge = queue_front(qa);
+			state = (quad->state & 0x01) | edge->state << 1;
+			++qa->tail;
+		} else if (!queue_empty(qb)) {
+			edge = queue_front(qb);
+			state = (quad->state & 0x02) | edge->state;
+			++qb->tail;
+		} else {
+			break;
+		}
+
+		step = quad_table[quad->state << 2 | state];
+		if (2 == step)
+			++quad->errors;
+		else
+			quad->position += step;
+		quad->state = state;
+	}
+}
+
+void capture_period_init(capture_period_t *period, uint input)
+{
+	period->input = input;
+	period->started = False;
+	period->count = 0;
+	period->sum = 0;
+}
+
+void capture_period_update(capture_period_t *period)
+{
+	edge_queue_t *q = &queue[period->input];
+	const capture_edge_t *edge;
+
+	while (!queue_empty(q)) {
+		edge = queue_front(q);
+		if (edge->state) {
+			if (period->started && period->count < 0xFFFF) {
+				period->sum += (u16)(edge->time - period->last);
+				++period->count;
+			}
+			period->last = edge->time;
+			period->started = True;
+		}
+		++q->tail;
+	}
+}
+
+u16 capture_period_average(capture_period_t *period)
+{
+	u16 average = 0;
+
+	if (period->count)
+		average = period->sum / period->count;
+	period->sum = 0;
+	period->count = 0;
+	return average;
+}
+
+u32 capture_frequency(capture_period_t *period)
+{
+	u32 frequency = 0;
+
+	if (period->sum)
+		frequency = (u64)CAPTURE_CLOCK_HZ * period->count / period->sum;
+	period->sum = 0;
+	period->count = 0;
+	return frequency;
+}
+
+#pragma vector = TIMER0_B1_VECTOR
+__interrupt void TIMER0_B1_ISR(void)
+{
+	uint iv = __even_in_range(TB0IV, 14);
+	edge_queue_t *q;
+	uint input;
+	u8 state;
+
+	if (0 == iv || iv > 2 * CAPTURE_INPUT_COUNT)
+		return;
+
+	input = (iv >> 1) - 1;
+	q = &queue[input];
+	// The pin may have changed again since the capture, the mode has not
+	state = capture_state(input);
+	queue_edge(q, CAPTURE_CCR(input), state);
+	CAPTURE_CCTL(input) ^= CM_3;
+	// The opposite edge came before the switch, it has the time of now
+	if (pin_state(input) != state) {
+		queue_edge(q, TB0R, state ^ 1);
+		CAPTURE_CCTL(input) ^= CM_3;
+	}
+	// An edge was lost between the capture and this read
+	if (CAPTURE_CCTL(input) & COV) {
+		CAPTURE_CCTL(input) &= ~COV;
+		++q->overrun;
+	}
+	event_set_isr(EVENT_CAPTURE);
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/cobs.h"
+#include "include/crc16.h"
+#include "include/uart.h"
+
+static void frame_reset(cobs_decoder_t *dec)
+{
+	dec->error = False;
+	dec->code = 0;
+	dec->left = 0;
+	dec->length = 0;
+	dec->checked = 0;
+	dec->crc = CRC16_INIT;
+}
+
+void cobs_decoder_init(cobs_decoder_t *dec, u8 *buf, u16 size, event_id_t event)
+{
+	dec->buf = buf;
+	dec->size = size;
+	dec->event = event;
+	dec->ready = False;
+	dec->errors = 0;
+	frame_reset(dec);
+}
+
+static inline void emit(cobs_decoder_t *dec, u8 ch)
+{
+	if (dec->length < dec->size)
+		dec->buf[dec->length++] = ch;
+	else
+		dec->error = True;
+}
+
+// Brings the crc up to date with the decoded bytes, in one block
+static void crc_catch_up(cobs_decoder_t *dec)
+{
+	dec->crc = crc16_update(dec->crc, dec->buf + dec->checked,
+	                        dec->length - dec->checked);
+	dec->checked = dec->length;
+}
+
+// Returns True if the frame is valid
+static bool frame_end(cobs_decoder_t *dec)
+{
+	// The crc of a payload followed by its crc is 0
+	crc_catch_up(dec);
+	if (!dec->error && dec->code && 0 == dec->left && dec->length >= 2
+	    && 0 == dec->crc) {
+		dec->ready = True;
+		event_set(dec->event);
+		return True;
+	}
+
+	// Consecutive delimiters are not errors, just empty frames
+	if (dec->code)
+		++dec->errors;
+	frame_reset(dec);
+	return False;
+}
+
+u16 cobs_feed(cobs_decoder_t *dec, const u8 *data, u16 length)
+{
+	u16 i = 0;
+	u8 ch;
+
+	if (dec->ready)
+		return 0;
+
+	while (i < length) {
+		ch = data[i++];
+		if (0 == ch) {
+			if (frame_end(dec))
+				return i;
+		} else if (dec->left) {
+			emit(dec, ch);
+			--dec->left;
+		} else {
+			// A new block, the previous one ended with an implicit 0 unless
+			// it was a full block
+			if (dec->code && 0xFF != dec->code)
+				emit(dec, 0);
+			dec->code = ch;
+			dec->left = ch - 1;
+		}
+	}
+	crc_catch_up(dec);
+	return i;
+}
+
+void cobs_release(cobs_decoder_t *dec)
+{
+	dec->ready = False;
+	frame_reset(dec);
+}
+
+#ifndef UART_RX_FRAME_MODE
+void cobs_receive(cobs_decoder_t *dec)
+{
+	const u8 *data;
+	u16 length;
+
+	while (!dec->ready && 0 != (length = uart_rx_peek(&data)))
+		uart_rx_commit(cobs_feed(dec, data, length));
+}
+#endif
+
+u16 cobs_encode(u8 *dst, u16 size, const void *src, u16 length)
+{
+	const u8 *bytes = src;
+	u16 crc = crc16_update(CRC16_INIT, src, length);
+	u16 code_at = 0;
+	u16 out = 1;
+	u16 i;
+	u8 code = 1;
+	u8 ch;
+
+	if (size < COBS_ENCODED_SIZE(length))
+		return 0;
+
+	for (i = 0; i < length + 2; i++) {
+		if (i < length)
+			ch = bytes[i];
+		else
+			ch = (i == length) ? crc >> 8 : (u8)crc;
+
+		if (ch) {
+			dst[out++] = ch;
+			++code;
+		}
+		if (0 == ch || 0xFF == code) {
+			dst[code_at] = code;
+			code_at = out++;
+			code = 1;
+		}
+	}
+	dst[code_at] = code;
+	dst[out++] = 0;
+	return out;
+}
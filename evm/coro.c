@@ -0,0 +1,97 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/coro.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+
+#define CORO_LINE_ENDED 0xFFFF
+
+static coro_t *task[CORO_MAX_TASKS];
+// The task that is being resumed by its timeout, and its next timeout
+static coro_t *expiring;
+static u16 expiring_next;
+
+static u16 coro_timeout(int id, u16 latency)
+{
+	coro_t *coro = task[id];
+
+	coro->waiting = 0;
+	coro->flags = CORO_FLAG_TIMED_OUT;
+	expiring = coro;
+	expiring_next = 0;
+	coro->body(coro);
+	expiring = Null;
+	// A new timeout of the same task reuses this timer
+	return expiring_next;
+}
+
+void _coro_wait(coro_t *coro, event_reg_t events, u16 timeout_ms)
+{
+	coro->waiting = events;
+	coro->flags = 0;
+	if (0 == timeout_ms)
+		return;
+
+	coro->flags = CORO_FLAG_TIMING;
+	if (coro == expiring)
+		expiring_next = timeout_ms;
+	else
+		systimer_new_task(timeout_ms, coro_timeout, coro->index);
+}
+
+void _coro_end(coro_t *coro)
+{
+	coro->line = CORO_LINE_ENDED;
+	coro->waiting = 0;
+	task[coro->index] = Null;
+}
+
+bool coro_start(coro_t *coro, coro_fn_t body)
+{
+	uint i;
+
+	for (i = 0; i < CORO_MAX_TASKS; i++) {
+		if (Null == task[i]) {
+			task[i] = coro;
+			coro->body = body;
+			coro->line = 0;
+			coro->waiting = 0;
+			coro->index = i;
+			coro->flags = 0;
+			body(coro);
+			return True;
+		}
+	}
+	return False;
+}
+
+bool coro_is_running(const coro_t *coro)
+{
+	return coro->line != CORO_LINE_ENDED && task[coro->index] == coro;
+}
+
+void coro_post(event_id_t id)
+{
+	event_reg_t bit = CORO_EVENT(id);
+	coro_t *coro;
+	uint i;
+
+	for (i = 0; i < CORO_MAX_TASKS; i++) {
+		coro = task[i];
+		if (Null == coro || !(coro->waiting & bit))
+			continue;
+
+		coro->waiting = 0;
+		if (coro->flags & CORO_FLAG_TIMING)
+			systimer_delete_task(coro_timeout, i);
+		coro->flags = 0;
+		coro->woke = id;
+		coro->body(coro);
+	}
+}
+
+void coro_dispatch(void)
+{
+	coro_post(event_current());
+}
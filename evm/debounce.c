@@ -0,0 +1,131 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/debounce.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#define P_IN_BASE   0x00
+#define P_IES_BASE  0x18
+#define P_IE_BASE   0x1A
+#define P_IFG_BASE  0x1C
+
+#define PxIN(base)      (*((volatile u8*)(base) + P_IN_BASE))
+#define PxIES(base)     (*((volatile u8*)(base) + P_IES_BASE))
+#define PxIE(base)      (*((volatile u8*)(base) + P_IE_BASE))
+#define PxIFG(base)     (*((volatile u8*)(base) + P_IFG_BASE))
+
+typedef struct port_state {
+	u8            state;    // debounced state
+	u8            count0;   // vertical counter, bit 0 of every pin
+	u8            count1;   // vertical counter, bit 1 of every pin
+	volatile bool armed;    // the edge interrupts are enabled
+} port_state_t;
+
+static const debounce_port_t *table;
+static port_state_t port[DEBOUNCE_PORT_COUNT];
+static volatile bool sampling;
+
+/* Enables the edge interrupts towards the opposite of the debounced state,
+ * returns False if a pin has already moved away */
+static bool port_arm(const debounce_port_t *cfg, port_state_t *p)
+{
+	volatile u8 *base = cfg->port_base;
+	u8 pins = cfg->pins;
+
+	PxIES(base) = (PxIES(base) & ~pins) | (p->state & pins);
+	PxIFG(base) &= ~pins;
+	// If a pin changed while setting the edges, keep sampling
+	if ((PxIN(base) & pins) != p->state)
+		return False;
+	p->armed = True;
+	PxIE(base) |= pins;
+	return True;
+}
+
+// Returns True if all the pins of the port are stable
+static bool port_sample(const debounce_port_t *cfg, port_state_t *p)
+{
+	u8 delta = (PxIN(cfg->port_base) & cfg->pins) ^ p->state;
+	u8 toggle;
+
+	/* Count up the pins that differ from the state, reset the others. A pin
+	 * toggles when its counter wraps, on the 4th differing sample */
+	p->count1 = (p->count1 ^ p->count0) & delta;
+	p->count0 = ~p->count0 & delta;
+	toggle = delta & ~(p->count0 | p->count1);
+
+	if (toggle) {
+		p->state ^= toggle;
+		if (Null != cfg->on_change)
+			cfg->on_change(toggle, p->state);
+	}
+	return 0 == (p->count0 | p->count1);
+}
+
+static u16 debounce_sample(int id, u16 latency)
+{
+	bool stable = True;
+	uint i;
+
+	for (i = 0; i < DEBOUNCE_PORT_COUNT; i++) {
+		if (port[i].armed)
+			continue;
+		if (!port_sample(&table[i], &port[i]))
+			stable = False;
+		else
+			_uninterrupted(if (!port_arm(&table[i], &port[i])) stable = False);
+	}
+	if (!stable)
+		return DEBOUNCE_SAMPLE_MS;
+
+	// An ISR may have disarmed a port after it was checked above
+	_uninterrupted(
+		for (i = 0; i < DEBOUNCE_PORT_COUNT; i++)
+			if (!port[i].armed)
+				stable = False;
+		if (stable)
+			sampling = False;
+	);
+	return stable ? 0 : DEBOUNCE_SAMPLE_MS;
+}
+
+void debounce_init(const debounce_port_t *ports)
+{
+	uint i;
+
+	table = ports;
+	sampling = False;
+	for (i = 0; i < DEBOUNCE_PORT_COUNT; i++) {
+		port[i].state = PxIN(ports[i].port_base) & ports[i].pins;
+		port[i].count0 = 0;
+		port[i].count1 = 0;
+		port[i].armed = False;
+	}
+	// The first samples take the initial state and arm the ports
+	_uninterrupted(
+		sampling = True;
+		systimer_new_task_isr(DEBOUNCE_SAMPLE_MS, debounce_sample, 0);
+	);
+}
+
+void debounce_port_isr(uint index)
+{
+	const debounce_port_t *cfg = &table[index];
+
+	assert(index < DEBOUNCE_PORT_COUNT);
+	PxIE(cfg->port_base) &= ~cfg->pins;
+	PxIFG(cfg->port_base) &= ~cfg->pins;
+	port[index].armed = False;
+
+	if (!sampling) {
+		sampling = True;
+		systimer_new_task_isr(DEBOUNCE_SAMPLE_MS, debounce_sample, 0);
+	}
+}
+
+u8 debounce_state(uint index)
+{
+	return port[index].state;
+}
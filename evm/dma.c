@@ -0,0 +1,31 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/dma.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+static pfn_t dma_handlers[DMA_CHANNEL_COUNT] = {0};
+
+/* Pass Null as handler to unregister */
+void dma_register(uint channel, pfn_t handler)
+{
+	assert(channel < DMA_CHANNEL_COUNT);
+	dma_handlers[channel] = handler;
+}
+
+#pragma vector = DMA_VECTOR
+__interrupt void DMA_ISR(void)
+{
+	uint iv = __even_in_range(DMAIV, 16);
+	pfn_t handler;
+
+	if (iv == 0 || iv > 2 * DMA_CHANNEL_COUNT)
+		return;
+
+	handler = dma_handlers[(iv >> 1) - 1];
+	if (Null != handler) {
+		handler();
+		__bic_SR_register_on_exit(LPM4_bits);
+	}
+}
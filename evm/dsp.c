@@ -0,0 +1,124 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/dsp.h"
+#include "include/systimer.h"
+#include <msp430.h>
+
+/******************************* HARDWARE ***********************************/
+/* Sum of a[i] * b[i], count > 0 */
+#ifdef __MSP430_HAS_MPY32__
+static s32 multiply_accumulate(const s16 *a, const s16 *b, uint count)
+{
+	s32 sum;
+
+	_uninterrupted(
+		MPYS = *a++;
+		OP2 = *b++;
+		while (--count) {
+			MACS = *a++;
+			OP2 = *b++;
+		}
+		sum = ((s32)RESHI << 16) | RESLO;
+	);
+	return sum;
+}
+#else
+static s32 multiply_accumulate(const s16 *a, const s16 *b, uint count)
+{
+	s32 sum = 0;
+
+	while (count--)
+		sum += (s32)*a++ * *b++;
+	return sum;
+}
+#endif
+/****************************************************************************/
+
+void dsp_average_init(dsp_average_t *avg, u16 *history, u8 shift)
+{
+	uint i;
+
+	avg->history = history;
+	avg->shift = shift;
+	avg->index = 0;
+	avg->sum = 0;
+	for (i = 0; i < (1u << shift); i++)
+		history[i] = 0;
+}
+
+void dsp_average(dsp_average_t *avg, const u16 *in, u16 *out, uint count)
+{
+	u16 mask = (1u << avg->shift) - 1;
+	u16 index = avg->index;
+	u32 sum = avg->sum;
+	u16 sample;
+
+	while (count--) {
+		sample = *in++;
+		sum += sample;
+		sum -= avg->history[index];
+		avg->history[index] = sample;
+		index = (index + 1) & mask;
+		*out++ = sum >> avg->shift;
+	}
+	avg->index = index;
+	avg->sum = sum;
+}
+
+void dsp_fir_init(dsp_fir_t *fir, const s16 *coeffs, u16 taps, u16 decimate,
+                  s16 *history)
+{
+	uint i;
+
+	fir->coeffs = coeffs;
+	fir->history = history;
+	fir->taps = taps;
+	fir->decimate = decimate;
+	fir->index = 0;
+	fir->phase = 0;
+	for (i = 0; i < 2u * taps; i++)
+		history[i] = 0;
+}
+
+/* Every sample is written twice, taps apart, so the last taps samples are
+ * always contiguous in the history and the accumulation needs no wrapping.
+ * The coefficients are applied newest sample first. */
+uint dsp_fir(dsp_fir_t *fir, const s16 *in, s16 *out, uint count)
+{
+	s16 *history = fir->history;
+	u16 taps = fir->taps;
+	u16 index = fir->index;
+	u16 phase = fir->phase;
+	uint written = 0;
+	s32 sum;
+
+	while (count--) {
+		history[index] = history[index + taps] = *in++;
+		if (++phase == fir->decimate) {
+			phase = 0;
+			sum = multiply_accumulate(fir->coeffs, &history[index], taps);
+			out[written++] = (s16)(sum >> 15);
+		}
+		index = index ? index - 1 : taps - 1;
+	}
+	fir->index = index;
+	fir->phase = phase;
+	return written;
+}
+
+void dsp_min_max(const u16 *in, uint count, u16 *min, u16 *max)
+{
+	u16 low = *in;
+	u16 high = *in;
+
+	while (--count) {
+		++in;
+		if (*in < low)
+			low = *in;
+		else if (*in > high)
+			high = *in;
+	}
+	*min = low;
+	*max = high;
+}
@@ -2,12 +2,15 @@
  * Licensed under the MIT License. See the accompanying LICENSE file */
 
 #include "include/event.h"
+#include "include/supervisor.h"
+#include "include/governor.h"
 #include "include/debug.h"
 
 #define EVENTS_USED_BITMASK	(((((event_reg_t)1 << (EVENT_COUNT - 1)) - 1) << 1) + 1)
 
 volatile uint event_lpm = EVENT_LPM0;
 volatile event_reg_t event_list = 0;
+uint event_running = 0;
 static pfn_t event_handlers[EVENT_COUNT] = {0};
 
 /* Assuming most events that are defined are registered, it is faster to call
@@ -26,11 +29,19 @@ static void init_empty_handlers(void)
 
 static inline void disable_interrupt(void) { __disable_interrupt(); }
 static inline void enable_interrupt(void) { __enable_interrupt(); }
-static inline void before_sleep(void) {}
-static inline void after_sleep(void) {}
+static inline void before_sleep(void)
+{
+	supervisor_sleep();
+	governor_sleep();
+}
+static inline void after_sleep(void)
+{
+	supervisor_wake();
+	governor_wake();
+}
 static inline void enter_sleep(void) { __bis_SR_register(event_lpm); }
 
-static void _event_machine(void)
+EVM_RAMFUNC static void _event_machine(void)
 {
 	event_reg_t current;
 	event_reg_t bit;
@@ -41,7 +52,12 @@ static void _event_machine(void)
 			for (i = 0, bit = 1, current = event_list; i < EVENT_COUNT; i++) {
 				if (current & bit) {
 					event_list &= ~bit;
+					event_running = i;
+					supervisor_enter(i);
+					trace_dispatch_begin(i);
 					event_handlers[i]();
+					trace_dispatch_end(i);
+					supervisor_exit();
 					current = event_list;
 					if (!current)
 						goto sleep;
@@ -0,0 +1,156 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/gesture.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+
+#define TICKS(ms) (((ms) + GESTURE_TICK_MS - 1) / GESTURE_TICK_MS)
+#define QUEUE_MASK (GESTURE_QUEUE_SIZE - 1)
+typedef char queue_size_check[(GESTURE_QUEUE_SIZE & QUEUE_MASK) ? -1 : 1];
+
+typedef enum phases {
+	PHASE_IDLE = 0,
+	PHASE_PRESSED,     // waiting for the release or the long press
+	PHASE_RELEASED,    // waiting for the next click
+	PHASE_HOLDING      // long press reported, repeating until the release
+} phase_t;
+
+typedef struct input_state {
+	u8  phase;
+	u8  clicks;
+	u16 ticks;         // left until the timeout of the phase
+} input_state_t;
+
+typedef struct gesture_record {
+	u8 input;
+	u8 gesture;
+} gesture_record_t;
+
+static input_state_t input[GESTURE_INPUT_COUNT];
+static gesture_record_t queue[GESTURE_QUEUE_SIZE];
+static u8 queue_head;
+static u8 queue_tail;
+static u16 overrun;
+static bool scanning;
+
+static void emit(uint id, gesture_t gesture)
+{
+	if ((u8)(queue_head - queue_tail) < GESTURE_QUEUE_SIZE) {
+		queue[queue_head & QUEUE_MASK].input = id;
+		queue[queue_head & QUEUE_MASK].gesture = gesture;
+		++queue_head;
+		event_set_traced(EVENT_GESTURE);
+	} else {
+		++overrun;
+	}
+}
+
+static void enter(input_state_t *in, phase_t phase, u16 ticks)
+{
+	in->phase = phase;
+	in->ticks = ticks;
+}
+
+// A phase has timed out
+static void timeout(uint id, input_state_t *in)
+{
+	switch (in->phase) {
+		case PHASE_PRESSED:
+			emit(id, GESTURE_LONG_PRESS);
+			in->clicks = 0;
+			enter(in, PHASE_HOLDING, TICKS(GESTURE_REPEAT_MS));
+			break;
+		case PHASE_HOLDING:
+			emit(id, GESTURE_REPEAT);
+			in->ticks = TICKS(GESTURE_REPEAT_MS);
+			break;
+		case PHASE_RELEASED:
+			emit(id, 1 == in->clicks ? GESTURE_CLICK : GESTURE_DOUBLE_CLICK);
+			in->clicks = 0;
+			enter(in, PHASE_IDLE, 0);
+			break;
+		default:
+			break;
+	}
+}
+
+/* Counts down the inputs that are in a gesture, stops when all are idle */
+static u16 gesture_scan(int id, u16 latency)
+{
+	bool active = False;
+	uint i;
+
+	for (i = 0; i < GESTURE_INPUT_COUNT; i++) {
+		input_state_t *in = &input[i];
+
+		if (PHASE_IDLE == in->phase)
+			continue;
+		// A holding input without repeats just waits for the release
+		if (in->ticks && 0 == --in->ticks)
+			timeout(i, in);
+		if (PHASE_IDLE != in->phase)
+			active = True;
+	}
+
+	if (!active)
+		scanning = False;
+	return active ? GESTURE_TICK_MS : 0;
+}
+
+void gesture_init(void)
+{
+	uint i;
+
+	for (i = 0; i < GESTURE_INPUT_COUNT; i++) {
+		input[i].phase = PHASE_IDLE;
+		input[i].clicks = 0;
+	}
+	queue_tail = queue_head;
+	overrun = 0;
+}
+
+void gesture_input(uint id, bool pressed)
+{
+	input_state_t *in = &input[id];
+
+	assert(id < GESTURE_INPUT_COUNT);
+	if (pressed) {
+		if (PHASE_IDLE == in->phase || PHASE_RELEASED == in->phase)
+			enter(in, PHASE_PRESSED, TICKS(GESTURE_LONG_MS));
+	} else {
+		if (PHASE_PRESSED == in->phase) {
+			if (3 == ++in->clicks) {
+				emit(id, GESTURE_TRIPLE_CLICK);
+				in->clicks = 0;
+				enter(in, PHASE_IDLE, 0);
+			} else {
+				enter(in, PHASE_RELEASED, TICKS(GESTURE_CLICK_MS));
+			}
+		} else if (PHASE_HOLDING == in->phase) {
+			emit(id, GESTURE_LONG_RELEASE);
+			enter(in, PHASE_IDLE, 0);
+		}
+	}
+
+	if (PHASE_IDLE != in->phase && !scanning)
+		scanning = systimer_new_task(GESTURE_TICK_MS, gesture_scan, 0);
+}
+
+gesture_t gesture_read(uint *id)
+{
+	gesture_record_t *record;
+
+	if (queue_tail == queue_head)
+		return GESTURE_NONE;
+	record = &queue[queue_tail & QUEUE_MASK];
+	++queue_tail;
+	*id = record->input;
+	return (gesture_t)record->gesture;
+}
+
+u16 gesture_overruns(void)
+{
+	return overrun;
+}
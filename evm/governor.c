@@ -0,0 +1,237 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/governor.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#ifdef GOVERNOR_ENABLE
+
+#ifdef SYS_SLOW_DOMAIN
+#error "governor measures the load with TA2, which is used by SYS_SLOW_DOMAIN"
+#endif
+
+typedef struct operating_point {
+	u32 hz;
+	u16 dcorsel;   // DCO range of UCSCTL1
+	u16 flln;      // FLL multiplier, fDCO = 32 * (flln + 1) * 32768
+	u8  core;      // PMM core voltage level, from the device datasheet
+} operating_point_t;
+
+/* Slowest to fastest, the core levels are the minimums for the F5xx/F6xx
+ * (level 0: 8MHz, 1: 12MHz, 2: 20MHz, 3: 25MHz) */
+static const operating_point_t points[] = {
+	{  2097152, DCORSEL_3,  1, 0 },
+	{  4194304, DCORSEL_4,  3, 0 },
+	{  8388608, DCORSEL_5,  7, 1 },
+	{ 12582912, DCORSEL_5, 11, 2 },
+	{ 20971520, DCORSEL_6, 19, 3 },
+};
+
+#define POINT_COUNT  (sizeof(points) / sizeof(points[0]))
+#define WINDOW_TICKS SYS_TIME_MSEC(GOVERNOR_WINDOW_MS)
+#define SETTLE_TICKS ((u16)(GOVERNOR_SETTLE_MS * 32768UL / 1000))
+
+typedef char lowest_point_check[(GOVERNOR_LOWEST_POINT < POINT_COUNT) ? 1 : -1];
+
+// ACLK ticks spent out of sleep in the current window, updated by the hooks
+u16 governor_busy;
+u16 governor_woke;
+
+static uint point;
+static uint holds;
+static uint load;
+static u16 window_start;
+static u16 busy[GOVERNOR_WINDOWS];
+static u16 elapsed[GOVERNOR_WINDOWS];
+static uint slot;
+static uint filled;
+static uint failures;
+
+/******************************* HARDWARE ***********************************/
+/* The PMM level is changed one step at a time, with the supervisors moved
+ * ahead of the core voltage when raising and behind it when lowering */
+static void core_level_up(uint level)
+{
+	PMMCTL0_H = PMMPW_H;
+	SVSMHCTL = SVSHE | SVSHRVL0 * level | SVMHE | SVSMHRRL0 * level;
+	PMMIFG &= ~SVSMLDLYIFG;
+	SVSMLCTL = SVSLE | SVMLE | SVSMLRRL0 * level;
+	while (!(PMMIFG & SVSMLDLYIFG));
+	PMMIFG &= ~(SVMLVLRIFG | SVMLIFG);
+	PMMCTL0_L = PMMCOREV0 * level;
+	if (PMMIFG & SVMLIFG)
+		while (!(PMMIFG & SVMLVLRIFG));
+	SVSMLCTL = SVSLE | SVSLRVL0 * level | SVMLE | SVSMLRRL0 * level;
+	PMMCTL0_H = 0;
+}
+
+static void core_level_down(uint level)
+{
+	PMMCTL0_H = PMMPW_H;
+	PMMIFG &= ~SVSMLDLYIFG;
+	SVSMLCTL = SVSLE | SVSLRVL0 * level | SVMLE | SVSMLRRL0 * level;
+	while (!(PMMIFG & SVSMLDLYIFG));
+	PMMCTL0_L = PMMCOREV0 * level;
+	PMMCTL0_H = 0;
+}
+
+static inline uint core_level(void)
+{
+	return PMMCTL0_L & PMMCOREV_3;
+}
+
+/* Returns False if the oscillator faults are still set after
+ * GOVERNOR_SETTLE_MS, TA2 should be running */
+static bool dco_set(const operating_point_t *p)
+{
+	u16 start;
+
+	// The FLL is disabled while the range and the multiplier change
+	__bis_SR_register(SCG0);
+	UCSCTL0 = 0;
+	UCSCTL1 = p->dcorsel;
+	UCSCTL2 = FLLD_5 | p->flln;
+	__bic_SR_register(SCG0);
+
+	start = governor_timestamp();
+	do {
+		UCSCTL7 &= ~(XT2OFFG | XT1LFOFFG | DCOFFG);
+		SFRIFG1 &= ~OFIFG;
+		if (!(SFRIFG1 & OFIFG))
+			return True;
+	} while ((u16)(governor_timestamp() - start) < SETTLE_TICKS);
+	return False;
+}
+
+static inline void timestamp_start(void)
+{
+	TA2CTL = TASSEL_1 | MC_2 | TACLR;
+}
+/****************************************************************************/
+
+// Returns False if the point didn't settle and the previous one is restored
+static bool point_select(uint next)
+{
+	const operating_point_t *p = &points[next];
+	uint level = core_level();
+
+	while (level < p->core)
+		core_level_up(++level);
+	if (!dco_set(p)) {
+		// The core level is still enough for the previous point
+		p = &points[point];
+		dco_set(p);
+		++failures;
+	}
+	while (level > p->core)
+		core_level_down(--level);
+	point = p - points;
+	return point == next;
+}
+
+static void window_reset(void)
+{
+	window_start = governor_timestamp();
+	governor_woke = window_start;
+	governor_busy = 0;
+	filled = 0;
+	slot = 0;
+}
+
+static u16 governor_sample(int id, u16 latency)
+{
+	u16 now = governor_timestamp();
+	u32 busy_sum = 0;
+	u32 elapsed_sum = 0;
+	uint next = point;
+	uint i;
+
+	// This task is running, so the time since the wake-up is busy
+	busy[slot] = governor_busy + (u16)(now - governor_woke);
+	elapsed[slot] = now - window_start;
+	governor_busy = 0;
+	governor_woke = now;
+	window_start = now;
+
+	if (++slot == GOVERNOR_WINDOWS)
+		slot = 0;
+	if (filled < GOVERNOR_WINDOWS)
+		++filled;
+
+	for (i = 0; i < filled; i++) {
+		busy_sum += busy[i];
+		elapsed_sum += elapsed[i];
+	}
+	load = elapsed_sum ? (uint)(busy_sum * 100 / elapsed_sum) : 0;
+
+	if (holds)
+		return WINDOW_TICKS;
+
+	if (load > GOVERNOR_UP_PERCENT) {
+		next = POINT_COUNT - 1;
+	} else if (GOVERNOR_WINDOWS == filled && point > GOVERNOR_LOWEST_POINT) {
+		// The load scales with the inverse of the frequency
+		u32 slower = (u32)load * (points[point].hz >> 15)
+		             / (points[point - 1].hz >> 15);
+		if (slower < GOVERNOR_DOWN_PERCENT)
+			next = point - 1;
+	}
+
+	if (next != point) {
+		if (point_select(next))
+			event_set_traced(EVENT_CLOCK_CHANGE);
+		window_reset();
+	}
+	return WINDOW_TICKS;
+}
+
+void governor_init(void)
+{
+	timestamp_start();
+	point = GOVERNOR_LOWEST_POINT;
+	failures = 0;
+	point_select(POINT_COUNT - 1);
+	holds = 0;
+	load = 0;
+}
+
+void governor_start(void)
+{
+	timestamp_start();
+	window_reset();
+	systimer_new_task(WINDOW_TICKS, governor_sample, 0);
+}
+
+u32 governor_smclk(void)
+{
+	return points[point].hz;
+}
+
+uint governor_load(void)
+{
+	return load;
+}
+
+uint governor_failures(void)
+{
+	return failures;
+}
+
+void governor_hold(void)
+{
+	_uninterrupted(++holds);
+}
+
+void governor_release(void)
+{
+	_uninterrupted(
+		assert(holds);
+		if (holds)
+			--holds;
+	);
+}
+
+#endif /* GOVERNOR_ENABLE */
@@ -0,0 +1,164 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/i2c.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+typedef char queue_size_check[(I2C_QUEUE & (I2C_QUEUE - 1)) ? -1 : 1];
+
+// Submitted transfers, the one at queue_tail is on the bus
+static i2c_transfer_t *queue[I2C_QUEUE];
+static volatile u8 queue_head;
+static volatile u8 queue_tail;
+
+typedef enum phase {
+	PHASE_WRITE,
+	PHASE_READ,
+	PHASE_STOP
+} phase_t;
+
+// Progress of the transfer on the bus, only used by the ISR once started
+static u16 position;
+static phase_t phase;
+static bool nacked;
+
+static inline i2c_transfer_t *current(void)
+{
+	return queue[queue_tail & (I2C_QUEUE - 1)];
+}
+
+/******************************* HARDWARE ***********************************/
+static inline void bus_start_write(u8 address)
+{
+	UCB0I2CSA = address;
+	UCB0CTLW0 |= UCTR | UCTXSTT;
+}
+
+static inline void bus_start_read(u8 address, u16 length)
+{
+	UCB0I2CSA = address;
+	UCB0CTLW0 &= ~UCTR;
+	UCB0CTLW0 |= UCTXSTT;
+	// The stop of a single byte goes right after the address
+	if (1 == length) {
+		while (UCB0CTLW0 & UCTXSTT);
+		UCB0CTLW0 |= UCTXSTP;
+	}
+}
+
+static inline void bus_stop(void)
+{
+	UCB0CTLW0 |= UCTXSTP;
+}
+/****************************************************************************/
+
+// Don't use with interrupts enabled
+static void transfer_start(void)
+{
+	i2c_transfer_t *t;
+
+	if (queue_tail == queue_head)
+		return;
+
+	t = current();
+	position = 0;
+	nacked = False;
+	if (t->write_length) {
+		phase = PHASE_WRITE;
+		bus_start_write(t->address);
+	} else {
+		phase = PHASE_READ;
+		bus_start_read(t->address, t->read_length);
+	}
+}
+
+// Called on the stop, the next transfer starts right away
+static void transfer_end(void)
+{
+	i2c_transfer_t *t = current();
+
+	++queue_tail;
+	t->status = nacked ? I2C_NACK : I2C_DONE;
+	event_set_traced(t->event);
+	transfer_start();
+}
+
+void i2c_init(void)
+{
+	UCB0CTLW0 = UCSWRST;
+	UCB0CTLW0 |= UCMST | UCMODE_3 | UCSYNC | UCSSEL__SMCLK;
+	UCB0BRW = I2C_CLOCK_HZ / I2C_BUS_HZ;
+	UCB0CTLW0 &= ~UCSWRST;
+	UCB0IE = UCNACKIE | UCSTPIE | UCRXIE0 | UCTXIE0;
+
+	queue_tail = queue_head;
+}
+
+bool i2c_submit(i2c_transfer_t *transfer)
+{
+	bool accepted = False;
+
+	assert(transfer->write_length || transfer->read_length);
+
+	_uninterrupted(
+		if ((u8)(queue_head - queue_tail) < I2C_QUEUE) {
+			transfer->status = I2C_BUSY;
+			queue[queue_head & (I2C_QUEUE - 1)] = transfer;
+			// Only start if the bus was idle
+			if (queue_head++ == queue_tail)
+				transfer_start();
+			accepted = True;
+		}
+	);
+	return accepted;
+}
+
+uint i2c_slots(void)
+{
+	return I2C_QUEUE - (u8)(queue_head - queue_tail);
+}
+
+#pragma vector = USCI_B0_VECTOR
+__interrupt void USCI_B0_ISR(void)
+{
+	i2c_transfer_t *t = current();
+
+	switch (__even_in_range(UCB0IV, 0x1E)) {
+		case 0x04:  // NACK, end the transfer with a stop
+			nacked = True;
+			phase = PHASE_STOP;
+			bus_stop();
+			break;
+		case 0x08:  // stop sent, the transfer is over
+			transfer_end();
+			__bic_SR_register_on_exit(LPM4_bits);
+			break;
+		case 0x16:  // rx
+			// The stop has to be set while the last byte is being received
+			if (position + 2 == t->read_length)
+				bus_stop();
+			if (position < t->read_length)
+				t->read[position++] = UCB0RXBUF;
+			else
+				(void)UCB0RXBUF;
+			break;
+		case 0x18:  // tx
+			if (PHASE_WRITE != phase)
+				break;
+			if (position < t->write_length) {
+				UCB0TXBUF = t->write[position++];
+			} else if (t->read_length) {
+				position = 0;
+				phase = PHASE_READ;
+				bus_start_read(t->address, t->read_length);
+			} else {
+				phase = PHASE_STOP;
+				bus_stop();
+			}
+			break;
+		default: break;
+	}
+}
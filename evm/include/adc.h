@@ -0,0 +1,50 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef ADC_H
+#define ADC_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Samples per block, the event machine wakes up once per block */
+#define ADC_BLOCK_SIZE  64
+/* Sample rate, TA0 divides ACLK(32768Hz) by 32768 / ADC_SAMPLE_HZ */
+#define ADC_SAMPLE_HZ   1024
+/* Input channel and the reference of ADC12MCTL0 */
+#define ADC_INPUT       ADC12INCH_0
+#define ADC_REFERENCE   ADC12SREF_0
+/* Sample and hold time, in ADC12OSC cycles(ADC12SHT0_2 = 16) */
+#define ADC_SAMPLE_HOLD ADC12SHT0_2
+/* DMA trigger number of ADC12IFGx, device specific, look it up in the
+ * datasheet. The DMA channel 2 is used */
+#define ADC_DMA_TRIGGER 24
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Continuous sampling of one ADC12 input into two blocks, without the cpu.
+ * - TA0.1 triggers every conversion, the DMA moves the result into the block
+ *   being filled. When a block is full, the DMA goes on with the other one
+ *   without a gap and EVENT_ADC is set. EVENT_ADC should be defined in
+ *   user_events.h, its handler takes the block with adc_block and gives it
+ *   back with adc_release.
+ * - A block should be released before the other one is full, that is within
+ *   ADC_BLOCK_SIZE samples. Otherwise the new block replaces it and it is
+ *   counted as an overrun, while it is already being overwritten.
+ * - TA0 belongs to this module, it can't be used with UART_RX_FRAME_MODE or
+ *   TRACE_ENABLE.
+ * - The ADC12 runs from its own oscillator and the timer from ACLK, only the
+ *   DMA transfers need MCLK. The analog pin is configured by the application.
+ * - The dsp module has the block kernels to process the samples.
+ */
+/****************************************************************************/
+
+void adc_init(void);
+void adc_start(void);
+void adc_stop(void);
+/* The full block, Null if there is none. Valid until adc_release */
+const u16 *adc_block(void);
+void adc_release(void);
+u16 adc_overruns(void);
+
+#endif /* ADC_H */
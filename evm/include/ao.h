@@ -0,0 +1,93 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef AO_H
+#define AO_H
+
+#include "types.h"
+#include "event.h"
+
+/**************************   MODIFY   **************************************/
+#define AO_MAX_OBJECTS  4
+/* Signals that can wait per active object, should be a power of 2 */
+#define AO_QUEUE_SIZE   8
+/* Maximum nesting depth of the states, at most 8 */
+#define AO_MAX_DEPTH    4
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Active objects: hierarchical state machines with their own signal queues,
+ * run from one event of the event machine.
+ * - EVENT_AO should be defined in user_events.h, ao_init registers it.
+ * - Every state has a const transition table indexed by the signal, so a
+ *   signal finds its transition in constant time. If the state doesn't handle
+ *   the signal(no action and no target), its parent state is tried.
+ * - A transition with a target exits the states up to the common ancestor,
+ *   runs the action, then enters the states down to the target, and further
+ *   into the initial substates. Without a target it is an internal transition,
+ *   only the action runs.
+ * - A state with a timeout starts its state timer on entry, the expiry is
+ *   delivered as AO_SIG_TIMEOUT to that state(and its parents if it doesn't
+ *   handle it), not to the substates. The timer is cancelled when the state
+ *   is exited, a late expiry is never delivered. Every nesting level has its
+ *   own timer, so a parent's timeout runs on while its substates come and
+ *   go with theirs. The timers are systimer tasks with the id
+ *   index * AO_MAX_DEPTH + depth, count them into the systimer's slots.
+ * - Signals are processed in run-to-completion steps, the objects in the
+ *   order they were started(priority).
+ * - ao_post can be called from an isr, then use ao_post_isr in the isr body.
+ */
+/****************************************************************************/
+
+/* The user signals start from AO_SIG_USER */
+#define AO_SIG_TIMEOUT  0
+#define AO_SIG_USER     1
+
+typedef struct ao ao_t;
+typedef struct ao_state ao_state_t;
+typedef void (*ao_action_t)(ao_t *ao);
+
+typedef struct ao_transition {
+	ao_action_t       action;    // can be Null
+	const ao_state_t *target;    // Null for an internal transition
+} ao_transition_t;
+
+struct ao_state {
+	const ao_state_t      *parent;     // Null for a top state
+	const ao_state_t      *initial;    // substate entered after this one, or Null
+	ao_action_t            entry;
+	ao_action_t            exit;
+	const ao_transition_t *table;      // the object's signal count long, or Null
+	u16                    timeout_ms; // 0 for no state timer
+};
+
+struct ao {
+	const ao_state_t *state;       // the current leaf state
+	// Per depth, the state whose timer is running
+	const ao_state_t *timer_owner[AO_MAX_DEPTH];
+	u8                expired;     // bit per depth, the timer expired
+	u8                signals;     // length of the transition tables
+	u8                index;
+	volatile u8       head;
+	volatile u8       tail;
+	u8                queue[AO_QUEUE_SIZE];
+	u16               overrun;
+	void             *data;        // for the application
+};
+
+/* Call after systimer_init */
+void ao_init(void);
+/* Enters the initial state, returns False if there are AO_MAX_OBJECTS */
+bool ao_start(ao_t *ao, const ao_state_t *initial, u8 signals);
+/* Queues the signal, returns False if the queue is full */
+bool ao_post(ao_t *ao, u8 signal);
+
+#define ao_post_isr(ao, signal) do \
+	{	ao_post(ao, signal); \
+		__bic_SR_register_on_exit(LPM4_bits); \
+	} while (0)
+
+/* True if the state is the current state or one of its ancestors */
+bool ao_in_state(const ao_t *ao, const ao_state_t *state);
+
+#endif /* AO_H */
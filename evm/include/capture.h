@@ -0,0 +1,82 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Number of inputs, input n is the capture channel TB0CCR(n+1) and its CCIxA
+ * pin, look up the pins in the datasheet */
+#define CAPTURE_INPUT_COUNT 2
+/* Edges that can wait per input, should be a power of 2 */
+#define CAPTURE_QUEUE_SIZE  16
+/* Timer_B clock source and its frequency, the timestamps are in its ticks */
+#define CAPTURE_CLOCK       TBSSEL__SMCLK
+#define CAPTURE_CLOCK_HZ    20971520UL
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Timestamped edge capture on Timer_B, for signals faster than one edge per
+ * event dispatch.
+ * - Every edge of an input is captured by the hardware, the ISR only queues
+ *   the timestamp and the pin state after the edge, then sets EVENT_CAPTURE.
+ *   EVENT_CAPTURE should be defined in user_events.h, its handler takes the
+ *   queued edges in bulk.
+ * - The channels capture the rising and the falling edges in turn, so the
+ *   state is that of the capture mode, not of the pin at the ISR. An edge
+ *   that comes before the ISR switches the mode is queued with the time of
+ *   the ISR.
+ * - The timestamps are 16 bits, time differences are valid up to 65535
+ *   ticks. Edges that don't fit the queue are counted as overruns.
+ * - An input's edges are consumed either with capture_read or by one of the
+ *   decoders, not both.
+ * - The port pins should be configured for the timer function by the
+ *   application.
+ */
+/****************************************************************************/
+
+typedef struct capture_edge {
+	u16 time;
+	u8  state;
+} capture_edge_t;
+
+void capture_init(void);
+/* Copies at most max edges of the input, oldest first, returns the amount */
+uint capture_read(uint input, capture_edge_t *edges, uint max);
+u16 capture_overruns(uint input);
+
+/* Quadrature decoder on two inputs, the position goes up when A leads B.
+ * Impossible transitions(both changed) are counted as errors. */
+typedef struct capture_quad {
+	uint a;
+	uint b;
+	s32  position;
+	u8   state;       // A << 1 | B
+	u16  errors;
+} capture_quad_t;
+
+void capture_quad_init(capture_quad_t *quad, uint input_a, uint input_b);
+/* Consumes the edges of both inputs in time order */
+void capture_quad_update(capture_quad_t *quad);
+
+/* Period measurement between the rising edges of an input, averaged over
+ * the periods since the last result */
+typedef struct capture_period {
+	uint input;
+	bool started;
+	u16  last;
+	u16  count;       // periods in sum
+	u32  sum;         // ticks
+} capture_period_t;
+
+void capture_period_init(capture_period_t *period, uint input);
+/* Consumes the edges of the input */
+void capture_period_update(capture_period_t *period);
+/* Average period in ticks since the last call, 0 if there was no period */
+u16 capture_period_average(capture_period_t *period);
+/* Average frequency in Hz since the last call, 0 if there was no period */
+u32 capture_frequency(capture_period_t *period);
+
+#endif /* CAPTURE_H */
@@ -0,0 +1,65 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef COBS_H
+#define COBS_H
+
+#include "types.h"
+#include "event.h"
+
+/***************************** READ FIRST ***********************************/
+/* COBS framing with a CRC-16, for binary protocols over the uart.
+ * - A frame on the line is the COBS encoding of the payload followed by its
+ *   crc16(MSB first), then a 0 delimiter. COBS removes the zeros from the
+ *   data, so any 0 on the line is the end of a frame and the receiver
+ *   resynchronizes on it after an error.
+ * - The decoder is incremental, feed it any pieces of the input as they
+ *   arrive. It decodes straight into the destination buffer and keeps the
+ *   running CRC, nothing is scanned twice.
+ * - When a valid frame is complete, the decoder sets its event and stops
+ *   taking input until cobs_release. Invalid frames are counted and dropped.
+ */
+/****************************************************************************/
+
+typedef struct cobs_decoder {
+	u8         *buf;
+	u16         size;
+	event_id_t  event;      // set for every valid frame
+	bool        ready;      // a valid frame is waiting in buf
+	bool        error;      // the current frame is invalid
+	u8          code;       // code of the current block, 0 before the first
+	u8          left;       // data bytes left in the current block
+	u16         length;     // decoded bytes of the current frame
+	u16         checked;    // bytes of buf that are already in the crc
+	u16         crc;
+	u16         errors;     // number of invalid frames
+} cobs_decoder_t;
+
+/* Maximum encoded size of a payload, including the crc and the delimiter */
+#define COBS_ENCODED_SIZE(length) ((length) + 2 + ((length) + 2) / 254 + 2)
+
+void cobs_decoder_init(cobs_decoder_t *dec, u8 *buf, u16 size, event_id_t event);
+
+/* Decodes from the data, returns the amount used. Stops after a valid frame,
+ * the rest of the data should be fed again after cobs_release */
+u16 cobs_feed(cobs_decoder_t *dec, const u8 *data, u16 length);
+
+/* Payload length of the waiting frame, 0 if there is none */
+static inline u16 cobs_frame_length(const cobs_decoder_t *dec)
+{
+	return dec->ready ? dec->length - 2 : 0;
+}
+
+/* Frees the buffer for the next frame */
+void cobs_release(cobs_decoder_t *dec);
+
+/* Feeds the decoder from the uart rx ring in place, until the ring is empty
+ * or a frame is ready. Call it on EVENT_UART_RX and after cobs_release.
+ * Not available in UART_RX_FRAME_MODE. */
+void cobs_receive(cobs_decoder_t *dec);
+
+/* Encodes the payload with its crc and the delimiter into dst, returns the
+ * encoded length. Returns 0 if size is less than COBS_ENCODED_SIZE(length). */
+u16 cobs_encode(u8 *dst, u16 size, const void *src, u16 length);
+
+#endif /* COBS_H */
@@ -0,0 +1,108 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef CORO_H
+#define CORO_H
+
+#include "types.h"
+#include "event.h"
+
+/**************************   MODIFY   **************************************/
+/* Maximum number of tasks running at the same time */
+#define CORO_MAX_TASKS 8
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Stackless coroutine tasks on top of the events and the systimer, so that a
+ * multi-step flow can be written as one sequential function:
+ *
+ *     CORO(measure)
+ *     {
+ *         CORO_BEGIN();
+ *         sensor_power_on();
+ *         AWAIT_TIMEOUT(20);
+ *         adc_start();
+ *         AWAIT_EITHER(EVENT_ADC, 5);
+ *         if (!CORO_TIMED_OUT())
+ *             send_result();
+ *         sensor_power_off();
+ *         CORO_END();
+ *     }
+ *
+ * - A task only keeps its resume point and what it waits for, there is no
+ *   stack. The local variables are lost at every AWAIT, keep the state in
+ *   static variables. Don't use AWAIT inside a switch statement.
+ * - The awaited events should be routed to the tasks: register coro_dispatch
+ *   as their handler with coro_register_event, or call coro_post from their
+ *   own handlers.
+ * - An event that is set while no task waits for it is lost for the tasks, as
+ *   the events are binary semaphores.
+ * - A timeout uses one systimer task slot while it is running. The timeout of
+ *   AWAIT_EITHER is cancelled if the event comes first.
+ */
+/****************************************************************************/
+
+typedef struct coro coro_t;
+typedef void (*coro_fn_t)(coro_t *coro);
+
+struct coro {
+	coro_fn_t    body;
+	u16          line;       // resume point
+	event_reg_t  waiting;    // awaited events
+	u8           index;      // in the task table, also the timer id
+	u8           flags;
+	u8           woke;       // the event that woke the task
+};
+
+#define CORO_EVENT(id) ((event_reg_t)1 << (id))
+
+#define CORO(name) void name(coro_t *_coro)
+#define CORO_BEGIN() switch (_coro->line) { case 0:
+#define CORO_END() } _coro_end(_coro); return
+
+#define _CORO_YIELD() do { \
+		_coro->line = __LINE__; return; case __LINE__:; \
+	} while (0)
+
+#define AWAIT_EVENT(id) do { \
+		_coro_wait(_coro, CORO_EVENT(id), 0); _CORO_YIELD(); \
+	} while (0)
+#define AWAIT_TIMEOUT(ms) do { \
+		_coro_wait(_coro, 0, ms); _CORO_YIELD(); \
+	} while (0)
+/* Resumes with whichever comes first */
+#define AWAIT_EITHER(id, ms) do { \
+		_coro_wait(_coro, CORO_EVENT(id), ms); _CORO_YIELD(); \
+	} while (0)
+/* Any of the events in the mask made with CORO_EVENT, ms can be 0 */
+#define AWAIT_ANY(mask, ms) do { \
+		_coro_wait(_coro, mask, ms); _CORO_YIELD(); \
+	} while (0)
+
+/* After an AWAIT: True if the timeout resumed the task, otherwise the event
+ * that resumed it */
+#define CORO_TIMED_OUT() (_coro->flags & CORO_FLAG_TIMED_OUT)
+#define CORO_WOKE_BY() ((event_id_t)_coro->woke)
+
+#define CORO_FLAG_TIMING     0x01
+#define CORO_FLAG_TIMED_OUT  0x02
+
+/* Runs the task until its first AWAIT, returns False if the table is full.
+ * The coro_t should stay in memory until the task ends. */
+bool coro_start(coro_t *coro, coro_fn_t body);
+bool coro_is_running(const coro_t *coro);
+
+/* Resumes the tasks waiting for the event */
+void coro_post(event_id_t id);
+/* An event handler calling coro_post for the current event */
+void coro_dispatch(void);
+
+static inline void coro_register_event(event_id_t id)
+{
+	event_register(id, coro_dispatch);
+}
+
+void _coro_wait(coro_t *coro, event_reg_t events, u16 timeout_ms);
+void _coro_end(coro_t *coro);
+
+#endif /* CORO_H */
@@ -0,0 +1,25 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include "types.h"
+
+/***************************** READ FIRST ***********************************/
+/* CRC-16/CCITT: polynomial 0x1021, not reflected, no final xor. Start with
+ * CRC16_INIT and update as the data arrives, in any number of pieces.
+ * - The CRC hardware module is used if the device has one, otherwise a 512
+ *   byte table. Both give the same result.
+ * - The hardware module is a single resource, don't use crc16_update from an
+ *   ISR and the main context at the same time.
+ * - Appending the result MSB first to the data makes the CRC of the whole 0,
+ *   that is how a received block with its CRC is checked.
+ */
+/****************************************************************************/
+
+#define CRC16_INIT 0xFFFF
+
+u16 crc16_update(u16 crc, const void *data, u16 length);
+
+#endif /* CRC16_H */
@@ -0,0 +1,49 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Number of entries in the port table given to debounce_init */
+#define DEBOUNCE_PORT_COUNT 2
+/* A pin has to read the same for 4 samples in a row to change its state, so
+ * the debounce time is 4 * DEBOUNCE_SAMPLE_MS */
+#define DEBOUNCE_SAMPLE_MS  5
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Debounces whole 8 bit ports with one shared timer task.
+ * - Every pin has a 2 bit vertical counter, the counter bits of all the pins
+ *   of a port are kept in two bytes. So a sample of a port debounces all of
+ *   its pins in a few logic operations.
+ * - An edge interrupt disables the port's interrupts and starts the sampling
+ *   timer, unless it is running already. When all the pins of a port are
+ *   stable again its interrupts are re-armed, when all the ports are stable
+ *   the timer stops. Nothing runs while the inputs are idle.
+ * - Call debounce_port_isr from the port's ISR with the port's index in the
+ *   table. The pins, the pulls and the other port interrupts are left to the
+ *   application.
+ * - The callbacks are called from the timer task, with the pins that changed
+ *   and the new state of all the debounced pins of the port.
+ */
+/****************************************************************************/
+
+typedef void (*debounce_callback_t)(u8 changed, u8 state);
+
+typedef struct debounce_port {
+	volatile u8         *port_base;   // &PxIN
+	u8                   pins;
+	debounce_callback_t  on_change;
+} debounce_port_t;
+
+/* The table should have DEBOUNCE_PORT_COUNT entries and stay in memory.
+ * Call after systimer_init. */
+void debounce_init(const debounce_port_t *ports);
+void debounce_port_isr(uint index);
+/* Debounced state of the port's pins */
+u8 debounce_state(uint index);
+
+#endif /* DEBOUNCE_H */
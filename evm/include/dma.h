@@ -0,0 +1,20 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef DMA_H
+#define DMA_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Number of DMA channels of the device */
+#define DMA_CHANNEL_COUNT 3
+/****************************************************************************/
+
+/* The DMA channels share one interrupt vector, the modules using them register
+ * a handler for their channel here. The handlers are called from the ISR, so
+ * they should use event_set, not event_set_isr; the DMA ISR always wakes the
+ * event machine up after calling a handler. */
+void dma_register(uint channel, pfn_t handler);
+
+#endif /* DMA_H */
@@ -0,0 +1,53 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef DSP_H
+#define DSP_H
+
+#include "types.h"
+
+/***************************** READ FIRST ***********************************/
+/* Fixed point kernels that process whole blocks of samples, e.g. the blocks of
+ * the adc module.
+ * - The FIR uses the MPY32 multiply-accumulate if the device has it. The
+ *   interrupts are disabled while one output is accumulated, because the ISRs
+ *   may use the multiplier too.
+ * - The 12 bit ADC samples fit s16, a block can be passed to the FIR as
+ *   (const s16 *).
+ * - The state of a kernel carries over between the blocks, so the blocks are
+ *   processed as one continuous signal.
+ */
+/****************************************************************************/
+
+/* Moving average over 2^shift samples, history needs 2^shift entries */
+typedef struct dsp_average {
+	u16  *history;
+	u8    shift;
+	u16   index;
+	u32   sum;
+} dsp_average_t;
+
+void dsp_average_init(dsp_average_t *avg, u16 *history, u8 shift);
+/* out[i] is the average of the window ending at in[i], out may be in */
+void dsp_average(dsp_average_t *avg, const u16 *in, u16 *out, uint count);
+
+/* FIR filter that keeps every decimate'th output. The coefficients are Q15,
+ * history needs 2 * taps entries */
+typedef struct dsp_fir {
+	const s16 *coeffs;
+	s16       *history;
+	u16        taps;
+	u16        decimate;
+	u16        index;
+	u16        phase;
+} dsp_fir_t;
+
+void dsp_fir_init(dsp_fir_t *fir, const s16 *coeffs, u16 taps, u16 decimate,
+                  s16 *history);
+/* Returns the number of outputs written, at most count / decimate + 1 */
+uint dsp_fir(dsp_fir_t *fir, const s16 *in, s16 *out, uint count);
+
+/* The smallest and the largest sample of the block, count > 0 */
+void dsp_min_max(const u16 *in, uint count, u16 *min, u16 *max);
+
+#endif /* DSP_H */
@@ -5,8 +5,25 @@
 #define EVENT_H
 
 #include "types.h"
+#include "trace.h"
 #include <msp430.h>
 
+/**************************   MODIFY   **************************************/
+/* Define on FRAM devices running faster than the FRAM(8MHz), to execute the
+ * dispatch loop and the systimer tick from RAM without the FRAM wait states.
+ * The linker command file should place and copy the section at startup:
+ * `.TI.ramfunc : {} load = FRAM, run = RAM, table(BINIT)` */
+// #define EVENT_RAM_CODE
+/****************************************************************************/
+
+/* Runs the function from RAM if EVENT_RAM_CODE is defined, mark the ISRs and
+ * the handlers that run on every wake-up with it too */
+#ifdef EVENT_RAM_CODE
+#define EVM_RAMFUNC __attribute__((ramfunc))
+#else
+#define EVM_RAMFUNC
+#endif
+
 /* Best to use the native integer type unless you want to have more events */
 typedef uint event_reg_t;
 #define EVENT_COUNT_MAX (8 * sizeof(event_reg_t))
@@ -67,7 +84,22 @@ static inline void event_set(event_id_t id)
 	event_list |= (event_reg_t)1 << id;
 }
 
+/* For the events set from an ISR or a DMA handler that leaves the wake-up to
+ * its ISR, and from the code shared with the main context. Recorded by the
+ * trace like event_set_isr */
+static inline void event_set_traced(event_id_t id)
+{
+	trace_event(id);
+	event_set(id);
+}
+
 #define event_set_isr(id) do \
+	{	trace_isr_event(id); \
+		_event_set_isr(id); \
+	} while (0)
+
+/* The same without tracing, for the events the replay generates itself */
+#define _event_set_isr(id) do \
 	{	event_set(id); \
 		__bic_SR_register_on_exit(LPM4_bits); \
 	} while (0)
@@ -80,4 +112,12 @@ static inline void event_clear(event_id_t id)
 	event_list &= ~((event_reg_t)1 << id);
 }
 
+/* The id of the event whose handler is running, so that one handler can
+ * serve several events */
+static inline event_id_t event_current(void)
+{
+	extern uint event_running;
+	return (event_id_t)event_running;
+}
+
 #endif /* EVENT_H */
@@ -0,0 +1,54 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+#define GESTURE_INPUT_COUNT 4
+/* Resolution of the gesture times */
+#define GESTURE_TICK_MS     10
+/* A release followed by a press within this time continues a multi-click */
+#define GESTURE_CLICK_MS    250
+/* Holding longer than this is a long press, then repeats every REPEAT_MS.
+ * Set GESTURE_REPEAT_MS to 0 for no repeats */
+#define GESTURE_LONG_MS     800
+#define GESTURE_REPEAT_MS   200
+/* Gestures that can wait for the handler, should be a power of 2 */
+#define GESTURE_QUEUE_SIZE  8
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Click, multi-click, long press and hold-repeat detection on debounced
+ * inputs, with one shared timer task for all of them.
+ * - Feed the debounced state changes with gesture_input, e.g. from the mspio
+ *   or debounce callbacks. The input numbers are up to the application.
+ * - The timer task runs only while a gesture is in progress.
+ * - The gestures are queued and EVENT_GESTURE is set, it should be defined in
+ *   user_events.h. Its handler reads them with gesture_read.
+ * - A single click is reported after GESTURE_CLICK_MS, when it is sure that
+ *   there is no second click. A triple click is reported on its release.
+ */
+/****************************************************************************/
+
+typedef enum gestures {
+	GESTURE_NONE = 0,
+	GESTURE_CLICK,
+	GESTURE_DOUBLE_CLICK,
+	GESTURE_TRIPLE_CLICK,
+	GESTURE_LONG_PRESS,
+	GESTURE_REPEAT,
+	GESTURE_LONG_RELEASE     // the release after a long press
+} gesture_t;
+
+void gesture_init(void);
+/* Call on every debounced change of the input, not from an isr */
+void gesture_input(uint input, bool pressed);
+/* Returns the oldest gesture and its input, GESTURE_NONE if there is none */
+gesture_t gesture_read(uint *input);
+/* Number of gestures lost because the queue was full */
+u16 gesture_overruns(void);
+
+#endif /* GESTURE_H */
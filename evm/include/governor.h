@@ -0,0 +1,99 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "types.h"
+#include <msp430.h>
+
+/**************************   MODIFY   **************************************/
+/* Define to let the event machine measure the busy time, see READ FIRST */
+// #define GOVERNOR_ENABLE
+/* The load is averaged over GOVERNOR_WINDOWS windows of GOVERNOR_WINDOW_MS */
+#define GOVERNOR_WINDOW_MS      250
+#define GOVERNOR_WINDOWS        4
+/* Above this load the fastest operating point is selected at once */
+#define GOVERNOR_UP_PERCENT     70
+/* One point slower is selected if the load would stay below this there */
+#define GOVERNOR_DOWN_PERCENT   40
+/* Slowest operating point that may be selected, an index into the table in
+ * governor.c(0 = 2MHz) */
+#define GOVERNOR_LOWEST_POINT   0
+/* Longest wait for the oscillator faults to clear after a DCO change */
+#define GOVERNOR_SETTLE_MS      50
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Scales MCLK/SMCLK(DCO with the FLL on XT1) and the PMM core voltage level
+ * between the operating points with the cpu load.
+ * - EVENT_CLOCK_CHANGE should be defined in user_events.h. It is set after
+ *   every change of SMCLK, its handler should adapt the drivers that run on
+ *   SMCLK, e.g. uart_set_clock(governor_smclk()).
+ * - The busy time is measured with TA2 running from ACLK, the time between
+ *   leaving and entering the sleep in the event machine. So it can't be used
+ *   together with SYS_SLOW_DOMAIN.
+ * - A systimer task evaluates the load every GOVERNOR_WINDOW_MS. When it is
+ *   above GOVERNOR_UP_PERCENT, the fastest point is selected. When the load
+ *   at the next slower point would be below GOVERNOR_DOWN_PERCENT, one point
+ *   down is selected. The measurements are discarded after every change.
+ * - The core voltage is raised before speeding up, and lowered after slowing
+ *   down. The cpu waits for the FLL and the PMM to settle, the interrupts are
+ *   not disabled meanwhile.
+ * - If the oscillator faults don't clear within GOVERNOR_SETTLE_MS, e.g. XT1
+ *   failed, the previous operating point is restored and counted in
+ *   governor_failures. No EVENT_CLOCK_CHANGE is set then.
+ * - Hold the governor while a peripheral on SMCLK is in the middle of a
+ *   transfer, e.g. during a uart_send. Holds are counted.
+ * - __delay_cycles and the other MCLK based delays scale with the clock.
+ */
+/****************************************************************************/
+
+#ifdef GOVERNOR_ENABLE
+
+/* Call after XT1 is started, the fastest operating point is selected */
+void governor_init(void);
+/* Starts the load measurement, call after systimer_init */
+void governor_start(void);
+/* Current SMCLK(and MCLK) frequency in Hz */
+u32 governor_smclk(void);
+/* Load averaged over the windows in percent */
+uint governor_load(void);
+/* Operating point changes that didn't settle */
+uint governor_failures(void);
+void governor_hold(void);
+void governor_release(void);
+
+static inline u16 governor_timestamp(void)
+{
+	u16 now;
+
+	// TA2 runs asynchronous to MCLK, read until two reads agree
+	do {
+		now = TA2R;
+	} while (now != TA2R);
+	return now;
+}
+
+/* Called by the event machine with the interrupts disabled */
+static inline void governor_sleep(void)
+{
+	extern u16 governor_busy;
+	extern u16 governor_woke;
+	governor_busy += governor_timestamp() - governor_woke;
+}
+
+static inline void governor_wake(void)
+{
+	extern u16 governor_woke;
+	governor_woke = governor_timestamp();
+}
+
+#else
+
+static inline void governor_sleep(void) {}
+static inline void governor_wake(void) {}
+
+#endif /* GOVERNOR_ENABLE */
+
+#endif /* GOVERNOR_H */
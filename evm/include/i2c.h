@@ -0,0 +1,59 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef I2C_H
+#define I2C_H
+
+#include "types.h"
+#include "event.h"
+
+/**************************   MODIFY   **************************************/
+/* SMCLK frequency and the bus clock, the divider is calculated from these */
+#define I2C_CLOCK_HZ 20971520
+#define I2C_BUS_HZ   400000
+/* Maximum number of transfers waiting or in progress, a power of 2 */
+#define I2C_QUEUE    8
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* An I2C master on eUSCI_B0 that works through a queue of transfers.
+ * - A transfer writes write_length bytes, then after a repeated start reads
+ *   read_length bytes, then stops. Either part can be empty, not both.
+ * - The ISR walks the queue by itself: the next transfer starts right after
+ *   the stop of the previous one, the event machine only wakes up for the
+ *   completion events. Several sensors can be read back to back while the cpu
+ *   sleeps(in LPM0, SMCLK is needed).
+ * - When a transfer ends its status is set and its event is set. The
+ *   transfer and its buffers should stay untouched while it is I2C_BUSY.
+ * - A transfer that is not acknowledged ends with I2C_NACK, the queue goes on
+ *   with the next one.
+ * - A read of a single byte waits in the ISR until the address is sent, to
+ *   set the stop in time.
+ * - The port pins and the clocks are configured by the application.
+ */
+/****************************************************************************/
+
+typedef enum i2c_status {
+	I2C_DONE = 0,
+	I2C_BUSY,
+	I2C_NACK
+} i2c_status_t;
+
+typedef struct i2c_transfer {
+	u8             address;       // 7 bit slave address
+	const u8      *write;
+	u16            write_length;
+	u8            *read;
+	u16            read_length;
+	event_id_t     event;         // set when the transfer ends
+	volatile u8    status;        // i2c_status_t
+} i2c_transfer_t;
+
+void i2c_init(void);
+/* Queues the transfer, returns False if I2C_QUEUE transfers are already
+ * waiting */
+bool i2c_submit(i2c_transfer_t *transfer);
+/* Number of transfers that can be submitted now */
+uint i2c_slots(void);
+
+#endif /* I2C_H */
@@ -0,0 +1,59 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Comment out to remove all the LOG calls from the build */
+#define LOG_ENABLE
+/* Size of the log ring buffer, should be a power of 2 */
+#define LOG_BUFFER_SIZE 128
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Tokenized logging: the format strings never leave the host.
+ * - LOG places its format string into the .logstr section and writes only
+ *   the string's address(16 bits) and the arguments as raw 16 bit words into
+ *   the log ring. Place .logstr as a COPY section in the linker command file,
+ *   e.g. `.logstr : {} > 0x0000, type = COPY`, so the strings take no memory
+ *   on the device but stay in the output file.
+ * - EVENT_LOG should be defined in user_events.h. The ring is sent through
+ *   uart_submit in the background, without copying.
+ * - tools/logdecode.py reads the strings from the output file and formats the
+ *   captured uart stream on the host.
+ * - The arguments are converted to u16. Pass 32 bit values with LOG_U32 and
+ *   use a %l conversion for them. %s is not supported.
+ * - A record that doesn't fit the ring is dropped, the number of dropped
+ *   records is sent as a record of its own once there is room.
+ * - LOG can be called from ISRs, but it doesn't wake the event machine up
+ *   there; the record is sent after the next wake-up.
+ */
+/****************************************************************************/
+
+// The id of the dropped records record, with one argument: the count
+#define LOG_ID_DROPPED 0xFFFF
+
+/* Splits a 32 bit value into two arguments, low word first */
+#define LOG_U32(x) (u16)(x), (u16)((u32)(x) >> 16)
+
+#ifdef LOG_ENABLE
+/* LOG("adc %u, time %lu", value, LOG_U32(time)) */
+#define LOG(...) _LOG(__VA_ARGS__, )
+
+#define _LOG(fmt, ...) do { \
+		static const char _log_fmt[] __attribute__((section(".logstr"))) = fmt; \
+		const u16 _log_record[] = {(u16)(uintptr_t)_log_fmt, __VA_ARGS__}; \
+		_log_write(_log_record, sizeof(_log_record)); \
+	} while (0)
+#else
+#define LOG(...)
+#endif
+
+/* Needs uart_init and systimer_init before */
+void log_init(void);
+void _log_write(const u16 *record, u16 size);
+
+#endif /* LOG_H */
@@ -0,0 +1,46 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef LPM5_H
+#define LPM5_H
+
+#include "types.h"
+#include "systimer.h"
+
+/**************************   MODIFY   **************************************/
+/* Maximum number of running timers that can be saved, across all domains */
+#define LPM5_MAX_TIMERS 8
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* LPM3.5 and LPM4.5 remove the power from the RAM, and the wake-up is a reset.
+ * This module saves the running timers into a persistent checkpoint(FRAM by
+ * default, see lpm5.c) before entering, and rebuilds them after the wake-up.
+ * It is only entered when no event is pending.
+ * - SYS_TIMER_CHECKPOINT should be defined in the systimer.h
+ * - If there is a timer that is not suspended, LPM3.5 is entered and the
+ *   RTC_C counter wakes the device up at the earliest deadline. Otherwise
+ *   LPM4.5 is entered and only the port interrupts can wake it up.
+ * - The callbacks are saved as function pointers, a checkpoint is only
+ *   accepted by the same firmware image that has written it.
+ * - Event handlers are not saved, the startup code registers them again.
+ */
+/****************************************************************************/
+
+/* Saves the state and enters LPMx.5, this only returns if an interrupt
+ * arrives while entering; then the RAM state is intact and the event machine
+ * continues as if nothing happened. Call it from an event handler when there
+ * is nothing left to do until the next deadline. Not from a timer callback:
+ * the systimer is in the middle of its update then, it returns False. Set an
+ * event from the callback and call it from the handler instead. Also returns
+ * False while an event is pending, call it again when that one is done. */
+bool lpm5_sleep(void);
+
+/* Call at startup after configuring the ports, registering the event handlers
+ * and systimer_init. If the reset is an LPMx.5 wake-up with a valid checkpoint,
+ * the timers are rebuilt and True is returned; then the startup code should
+ * not create its initial timers again. Also unlocks the port configuration
+ * (LOCKLPM5) in either case. */
+bool lpm5_restore(void);
+
+#endif /* LPM5_H */
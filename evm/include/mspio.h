@@ -0,0 +1,55 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef MSPIO_H
+#define MSPIO_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Delay in cycles after enabling a pull resistor, for the voltage to settle */
+#define MSPIO_PULL_CHARGE_DELAY 0
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Debounced inputs declared in one table, user_inputs.h:
+ * - MSPIO_INPUTS lists the inputs, one X(...) line each:
+ *     X(ctx, id, port, pin, pull, debounce_ms, longpress_ms, on_change, on_longpress)
+ *   id becomes MSPIO_<id>, port is the port number, pin a single BITx, pull
+ *   one of MSPIO_PULLUP, MSPIO_PULLDOWN, MSPIO_FLOATING. debounce_ms should
+ *   not be 0, longpress_ms is 0 if not used, the callbacks can be Null.
+ * - MSPIO_PORTS lists the port numbers used in MSPIO_INPUTS. An ISR is
+ *   generated for each one, mapping PxIV to the input through a lookup table
+ *   in flash; adding an input doesn't add any code. Don't use these port
+ *   vectors elsewhere.
+ * - An edge disables the pin's interrupt and its pull resistor, and starts
+ *   the input's debounce timer. So each input needs one timer while it is
+ *   debouncing and one more while its longpress timer runs.
+ * - The callbacks are called from the timer callbacks with the new state,
+ *   the longpress callback with the state that was held.
+ */
+/****************************************************************************/
+
+typedef enum mspio_pulls {
+	MSPIO_FLOATING = 0,
+	MSPIO_PULLUP,
+	MSPIO_PULLDOWN
+} mspio_pull_t;
+
+typedef void (*mspio_callback_t)(uint state);
+
+#include "user_inputs.h"
+
+#define _MSPIO_ENUM(ctx, id, ...) MSPIO_##id,
+typedef enum mspio_inputs {
+	MSPIO_INPUTS(_MSPIO_ENUM, ~)
+	MSPIO_INPUT_COUNT
+} mspio_input_id_t;
+#undef _MSPIO_ENUM
+
+/* Configures the pins and debounces the initial states, call after systimer_init */
+void mspio_init(void);
+/* Debounced state of the input, 0 or 1 */
+uint mspio_state(mspio_input_id_t id);
+
+#endif /* MSPIO_H */
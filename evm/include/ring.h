@@ -0,0 +1,97 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef RING_H
+#define RING_H
+
+#include "types.h"
+
+/***************************** READ FIRST ***********************************/
+/* A single producer, single consumer byte ring buffer.
+ * - The size should be a power of 2, at most 32768.
+ * - The producer only writes head and the consumer only writes tail, there is
+ *   no shared count. So one side can be an ISR and the other the main context
+ *   without disabling the interrupts, as long as each side has one user.
+ * - The indices run freely and are masked on access, head - tail is the count.
+ * - Bulk read/write copy in at most two memcpy segments. The peek/commit pairs
+ *   give direct access to the contiguous part, e.g. to let a DMA fill or drain
+ *   the buffer, then commit the amount that is actually used.
+ */
+/****************************************************************************/
+
+typedef struct ring {
+	u8           *buf;
+	u16           mask;
+	volatile u16  head;
+	volatile u16  tail;
+} ring_t;
+
+/* Defines a ring with its storage, a non power of 2 size fails to compile */
+#define RING_DEFINE(name, size) \
+	typedef char name##_size_check[((size) & ((size) - 1)) ? -1 : 1]; \
+	static u8 name##_buf[size]; \
+	static ring_t name = {name##_buf, (size) - 1, 0, 0}
+
+void ring_init(ring_t *ring, u8 *buf, u16 size);
+
+static inline u16 ring_count(const ring_t *ring)
+{
+	return ring->head - ring->tail;
+}
+
+static inline u16 ring_space(const ring_t *ring)
+{
+	return ring->mask + 1 - (u16)(ring->head - ring->tail);
+}
+
+/* Only the consumer should use this, it is equal to reading everything */
+static inline void ring_clear(ring_t *ring)
+{
+	ring->tail = ring->head;
+}
+
+/* Single char versions for the ISRs, put returns False if the ring is full
+ * and get returns -1 if it is empty */
+static inline bool ring_put(ring_t *ring, u8 ch)
+{
+	u16 head = ring->head;
+
+	if ((u16)(head - ring->tail) > ring->mask)
+		return False;
+	ring->buf[head & ring->mask] = ch;
+	ring->head = head + 1;
+	return True;
+}
+
+static inline int ring_get(ring_t *ring)
+{
+	u16 tail = ring->tail;
+	u8 ch;
+
+	if (tail == ring->head)
+		return -1;
+	ch = ring->buf[tail & ring->mask];
+	ring->tail = tail + 1;
+	return ch;
+}
+
+/* Copy as much as fits/is available, return the amount copied */
+u16 ring_write(ring_t *ring, const void *data, u16 length);
+u16 ring_read(ring_t *ring, void *data, u16 length);
+
+/* Zero-copy access: peek returns the contiguous length and points data to it,
+ * commit marks length bytes of it as written/read */
+u16 ring_peek_write(const ring_t *ring, u8 **data);
+u16 ring_peek_read(const ring_t *ring, const u8 **data);
+
+static inline void ring_commit_write(ring_t *ring, u16 length)
+{
+	ring->head += length;
+}
+
+static inline void ring_commit_read(ring_t *ring, u16 length)
+{
+	ring->tail += length;
+}
+
+#endif /* RING_H */
@@ -0,0 +1,56 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef SPI_H
+#define SPI_H
+
+#include "types.h"
+#include "event.h"
+
+/**************************   MODIFY   **************************************/
+/* SMCLK frequency and the bus clock, the divider is calculated from these */
+#define SPI_CLOCK_HZ 20971520
+#define SPI_BUS_HZ   4000000
+/* Clock phase and polarity bits of UCB1CTLW0, mode 0 by default */
+#define SPI_MODE     UCCKPH
+/* Maximum number of transfers waiting or in progress, a power of 2 */
+#define SPI_QUEUE    8
+/* Sent while reading */
+#define SPI_DUMMY    0xFF
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* An SPI master on eUSCI_B1 that works through a queue of transfers.
+ * - A transfer selects its device with its chip select pin(active low),
+ *   writes write_length bytes, then reads read_length bytes while sending
+ *   SPI_DUMMY, and deselects the device. The bytes received while writing are
+ *   dropped.
+ * - The ISR walks the queue by itself: the next transfer starts right after
+ *   the previous one, the event machine only wakes up for the completion
+ *   events.
+ * - When a transfer ends its event is set. The transfer and its buffers
+ *   should stay untouched while it is busy.
+ * - The chip select pins should be outputs and high before spi_init, the
+ *   other port pins and the clocks are configured by the application.
+ */
+/****************************************************************************/
+
+typedef struct spi_transfer {
+	volatile u8   *cs_port;       // &PxOUT of the chip select
+	u8             cs_pin;
+	const u8      *write;
+	u16            write_length;
+	u8            *read;
+	u16            read_length;
+	event_id_t     event;         // set when the transfer ends
+	volatile bool  busy;          // True from the submit until the end
+} spi_transfer_t;
+
+void spi_init(void);
+/* Queues the transfer, returns False if SPI_QUEUE transfers are already
+ * waiting */
+bool spi_submit(spi_transfer_t *transfer);
+/* Number of transfers that can be submitted now */
+uint spi_slots(void);
+
+#endif /* SPI_H */
@@ -0,0 +1,113 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include "types.h"
+#include <msp430.h>
+
+/**************************   MODIFY   **************************************/
+/* Define to let the event machine run the watchdog, see READ FIRST */
+// #define SUPERVISOR_ENABLE
+/* Default budget of an event handler, as a WDTIS interval of the 32768Hz ACLK:
+ * WDTIS__512 = 15.6ms, WDTIS__8192 = 250ms, WDTIS__32K = 1s */
+#define SUPERVISOR_BUDGET       WDTIS__8192
+/* Budget of each systimer callback, the watchdog is restarted before every
+ * callback of a tick and again after it returns */
+#define SUPERVISOR_TIMER_BUDGET WDTIS__8192
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* The watchdog is restarted only by the event machine itself: right before an
+ * event handler is dispatched, and before each timer callback. So it expires
+ * only when a single handler or callback runs longer than its budget, a task
+ * that merely feeds the dog can't hide a handler hogging the cpu.
+ * - The watchdog is held while the cpu sleeps, and restarted with
+ *   SUPERVISOR_BUDGET at the wake-up. That covers the way from the wake-up to
+ *   the first dispatch, but not an ISR that hangs before it wakes the cpu.
+ * - The application should not touch WDTCTL after event_machine is called.
+ * - The running event and timer callback are kept in no-init RAM, so they
+ *   survive the watchdog reset. Call supervisor_init first thing in main, it
+ *   reads the reset cause and keeps the culprit for supervisor_last.
+ * - supervisor_init reads SYSRSTIV until it is empty, the other reset causes
+ *   are consumed too.
+ * - Budgets are per event; the handler of the systimer tick event gets its
+ *   own budget for the bookkeeping, the callbacks get SUPERVISOR_TIMER_BUDGET
+ *   each.
+ */
+/****************************************************************************/
+
+// event of supervisor_record_t when no handler is running
+#define SUPERVISOR_IDLE 0xFFFF
+
+typedef struct supervisor_record {
+	u16   magic;
+	u16   resets;    // watchdog resets since the power-up
+	uint  event;     // running event, SUPERVISOR_IDLE if none
+	pfn_t timer;     // running timer callback, Null if none
+} supervisor_record_t;
+
+#ifdef SUPERVISOR_ENABLE
+
+/* Returns True if the last reset was a watchdog timeout. Call before
+ * anything else in main, it also holds the watchdog */
+bool supervisor_init(void);
+/* The state at the last watchdog reset, Null if the last reset was not one */
+const supervisor_record_t *supervisor_last(void);
+/* The budget is a WDTIS interval, see SUPERVISOR_BUDGET */
+void supervisor_set_budget(uint event, uint wdtis);
+
+/* Called by the event machine and the systimer, not by the application */
+static inline void supervisor_wake(void)
+{
+	WDTCTL = WDTPW | WDTSSEL__ACLK | WDTCNTCL | SUPERVISOR_BUDGET;
+}
+
+static inline void supervisor_enter(uint event)
+{
+	extern supervisor_record_t supervisor_now;
+	extern u8 supervisor_budget[];
+
+	supervisor_now.event = event;
+	WDTCTL = WDTPW | WDTSSEL__ACLK | WDTCNTCL | supervisor_budget[event];
+}
+
+static inline void supervisor_exit(void)
+{
+	extern supervisor_record_t supervisor_now;
+	supervisor_now.event = SUPERVISOR_IDLE;
+}
+
+static inline void supervisor_sleep(void) { WDTCTL = WDTPW | WDTHOLD; }
+
+static inline void supervisor_timer(pfn_t callback)
+{
+	extern supervisor_record_t supervisor_now;
+
+	supervisor_now.timer = callback;
+	WDTCTL = WDTPW | WDTSSEL__ACLK | WDTCNTCL | SUPERVISOR_TIMER_BUDGET;
+}
+
+// The rest of the tick handler gets a budget of its own again
+static inline void supervisor_timer_done(void)
+{
+	extern supervisor_record_t supervisor_now;
+	extern u8 supervisor_budget[];
+
+	supervisor_now.timer = Null;
+	WDTCTL = WDTPW | WDTSSEL__ACLK | WDTCNTCL | supervisor_budget[supervisor_now.event];
+}
+
+#else
+
+static inline void supervisor_wake(void) {}
+static inline void supervisor_enter(uint event) {}
+static inline void supervisor_exit(void) {}
+static inline void supervisor_sleep(void) {}
+static inline void supervisor_timer(pfn_t callback) {}
+static inline void supervisor_timer_done(void) {}
+
+#endif /* SUPERVISOR_ENABLE */
+
+#endif /* SUPERVISOR_H */
@@ -19,6 +19,32 @@
 /* If defined will stop the timer when not in use. It is better to use this
  * mode if you are not using the same timer for other purposes */
 #define SYS_TIMER_STOP_MODE
+/* If defined, drift-free periodic timers (systimer_new_periodic) become
+ * available. Each timer instance gets 6 bytes bigger to hold the period */
+// #define SYS_TIMER_PERIODIC
+
+/* If defined, a second independent timer domain SYS_DOMAIN_SLOW runs on
+ * TimerA2 with its own pool, tick event(EVENT_SYS_TICK_SLOW must be defined in
+ * the user_events.h) and stop mode. Its timeouts are given in seconds, so it
+ * is meant for minute-scale housekeeping that would otherwise keep the fast
+ * tick running and occupy the fast pool */
+// #define SYS_SLOW_DOMAIN
+#define SYS_SLOW_TIMER_MAX_COUNT 4
+/* Tick of the slow domain in seconds, 1 or 2 (limited by the 16 bit CCR0) */
+#define SYS_SLOW_TICK_SEC 1
+#define SYS_SLOW_TIMER_STOP_MODE
+
+/* If defined, each domain keeps pool health statistics, see systimer_stats_get.
+ * Use them to size SYS_TIMER_MAX_COUNT and SYS_TICK_MS, then undefine */
+// #define SYS_TIMER_STATS
+
+/* If defined, timers can be tagged with group bits and then suspended, resumed
+ * or cancelled all together, see systimer_group_suspend. Adds 1 byte per timer */
+// #define SYS_TIMER_GROUPS
+
+/* If defined, the running timers can be saved and rebuilt after a reset, this
+ * is required by the lpm5 module */
+// #define SYS_TIMER_CHECKPOINT
 /****************************************************************************/
 
 /* Since we are using 32768 ACLK as clock source, we can't get an exact 1ms
@@ -27,11 +53,23 @@
 #define SYS_TICK_IN_SEC    1024
 #define SYS_TIME_SEC(s)    (SYS_TICK_IN_SEC * (s))
 #define SYS_TIME_MSEC(ms)  ((((u32)(ms)) * SYS_TICK_IN_SEC + 500)/1000)
+/* Periodic timers don't round, they carry the remainder of the above division
+ * to the next period in units of 1/SYS_TICK_FRAC_DIV ticks */
+#define SYS_TICK_FRAC_DIV  1000
 
 /* A shortcut to add latency to a tasks new timeout return value */
 #define SYS_TIME_OFFSET_LATENCY(timeout, latency) \
     ((timeout) > (latency) ? (timeout) - (latency) : 1)
 
+typedef enum sys_domains {
+	SYS_DOMAIN_FAST = 0,
+#ifdef SYS_SLOW_DOMAIN
+	SYS_DOMAIN_SLOW,
+#endif
+	SYS_DOMAIN_COUNT
+} sys_domain_t;
+
+/* Initializes the hardware and registers the tick events of all domains */
 void systimer_init(void);
 
 /* Rather than controlling the return value of each systimer_new() call, it
@@ -43,14 +81,21 @@ void systimer_register_fail_callback(pfn_t callback);
 
 typedef u16 (*tcb_id_t)(int id, u16 latency);
 typedef void (*tcb_noid_t)(void);
+typedef void (*tcb_periodic_t)(int id);
 
-bool _systimer_new(u16 timeout_ms, tcb_noid_t callback, int id);
-bool _systimer_new_isr(u16 timeout_ms, tcb_noid_t callback, int id);
-bool _systimer_renew(u16 timeout_ms, tcb_noid_t callback, int id);
-bool _systimer_is_running(tcb_noid_t callback, int id);
+bool _systimer_new(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id);
+bool _systimer_new_isr(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id);
+bool _systimer_renew(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id);
+bool _systimer_is_running(sys_domain_t dom, tcb_noid_t callback, int id);
+#ifdef SYS_TIMER_PERIODIC
+bool _systimer_new_periodic(sys_domain_t dom, u16 period_ms, tcb_noid_t callback, int id);
+#endif
 
 /***************************** READ FIRST ***********************************/
-/* - These functions will return False if they fail to create a new
+/* - The functions below work on SYS_DOMAIN_FAST, the systimer_slow_ variants
+ *   at the end work on SYS_DOMAIN_SLOW. A timer instance belongs to the domain
+ *   it was created in, and renew/delete/is_running only look in that domain.
+ * - These functions will return False if they fail to create a new
  *   timer instance.
  * - What makes each timer instance unique is their function pointer and
  *   their id. So it is possible to register the same callback with
@@ -76,23 +121,23 @@ bool _systimer_is_running(tcb_noid_t callback, int id);
 /* Creates a new timer instance, use the isr version when calling this from an isr */
 static inline bool systimer_new(u16 timeout_ms, tcb_noid_t callback)
 {
-    return _systimer_new(timeout_ms, callback, -1);
+    return _systimer_new(SYS_DOMAIN_FAST, timeout_ms, callback, -1);
 }
 
 static inline bool systimer_new_task(u16 timeout_ms, tcb_id_t callback, int id)
 {
-    return _systimer_new(timeout_ms, (tcb_noid_t)callback, id);
+    return _systimer_new(SYS_DOMAIN_FAST, timeout_ms, (tcb_noid_t)callback, id);
 }
 
 /* The isr versions assume that the interrupts are disabled */
 static inline bool systimer_new_isr(u16 timeout_ms, tcb_noid_t callback)
 {
-    return _systimer_new_isr(timeout_ms, callback, -1);
+    return _systimer_new_isr(SYS_DOMAIN_FAST, timeout_ms, callback, -1);
 }
 
 static inline bool systimer_new_task_isr(u16 timeout_ms, tcb_id_t callback, int id)
 {
-    return _systimer_new_isr(timeout_ms, (tcb_noid_t)callback, id);
+    return _systimer_new_isr(SYS_DOMAIN_FAST, timeout_ms, (tcb_noid_t)callback, id);
 }
 
 /* Will change the timeout value of the timer that has the same function
@@ -103,36 +148,236 @@ static inline bool systimer_new_task_isr(u16 timeout_ms, tcb_id_t callback, int
  */
 static inline bool systimer_renew(u16 timeout_ms, tcb_noid_t callback)
 {
-    return _systimer_renew(timeout_ms, callback, -1);
+    return _systimer_renew(SYS_DOMAIN_FAST, timeout_ms, callback, -1);
 }
 
 static inline bool systimer_renew_task(u16 timeout_ms, tcb_id_t callback, int id)
 {
-    return _systimer_renew(timeout_ms, (tcb_noid_t)callback, id);
+    return _systimer_renew(SYS_DOMAIN_FAST, timeout_ms, (tcb_noid_t)callback, id);
 }
 
 /* This is syntactic sugar for renew with timeout 0 */
 static inline void systimer_delete(tcb_noid_t callback)
 {
-    _systimer_renew(0, callback, -1);
+    _systimer_renew(SYS_DOMAIN_FAST, 0, callback, -1);
 }
 
 static inline void systimer_delete_task(tcb_id_t callback, int id)
 {
-    _systimer_renew(0, (tcb_noid_t)callback, id);
+    _systimer_renew(SYS_DOMAIN_FAST, 0, (tcb_noid_t)callback, id);
 }
 
+#ifdef SYS_TIMER_PERIODIC
+/* Creates a periodic timer, its period is given in real miliseconds(not ticks).
+ * Unlike tcb_id_t tasks, the callback returns nothing: the next deadline is
+ * advanced by exactly one period from the previous deadline, not from the
+ * time the callback runs. The fraction lost by the 1024/1000 conversion is
+ * accumulated and carried into the following periods, so the timer stays
+ * phase-locked indefinitely. If the dispatch is late more than a whole period,
+ * the missed periods are skipped rather than called back-to-back.
+ * - The period should not exceed 30 seconds, same as the other timeouts.
+ * - systimer_delete_periodic is the only call that a timer callback is
+ *   allowed to use on itself.
+ */
+static inline bool systimer_new_periodic(u16 period_ms, tcb_periodic_t callback, int id)
+{
+    return _systimer_new_periodic(SYS_DOMAIN_FAST, period_ms, (tcb_noid_t)callback, id);
+}
+
+static inline void systimer_delete_periodic(tcb_periodic_t callback, int id)
+{
+    _systimer_renew(SYS_DOMAIN_FAST, 0, (tcb_noid_t)callback, id);
+}
+
+static inline bool systimer_is_running_periodic(tcb_periodic_t callback, int id)
+{
+    return _systimer_is_running(SYS_DOMAIN_FAST, (tcb_noid_t)callback, id);
+}
+#endif
+
 /* Just the know if the timer is running or not */
 static inline bool systimer_is_running(tcb_noid_t callback)
 {
-    return _systimer_is_running(callback, -1);
+    return _systimer_is_running(SYS_DOMAIN_FAST, callback, -1);
 }
 
 static inline bool systimer_is_running_task(tcb_id_t callback, int id)
 {
-    return _systimer_is_running((tcb_noid_t)callback, id);
+    return _systimer_is_running(SYS_DOMAIN_FAST, (tcb_noid_t)callback, id);
+}
+
+#ifdef SYS_SLOW_DOMAIN
+/* SYS_DOMAIN_SLOW variants, the timeouts are in seconds */
+static inline bool systimer_slow_new(u16 timeout_s, tcb_noid_t callback)
+{
+    return _systimer_new(SYS_DOMAIN_SLOW, timeout_s, callback, -1);
+}
+
+static inline bool systimer_slow_new_task(u16 timeout_s, tcb_id_t callback, int id)
+{
+    return _systimer_new(SYS_DOMAIN_SLOW, timeout_s, (tcb_noid_t)callback, id);
+}
+
+static inline bool systimer_slow_new_isr(u16 timeout_s, tcb_noid_t callback)
+{
+    return _systimer_new_isr(SYS_DOMAIN_SLOW, timeout_s, callback, -1);
 }
 
+static inline bool systimer_slow_new_task_isr(u16 timeout_s, tcb_id_t callback, int id)
+{
+    return _systimer_new_isr(SYS_DOMAIN_SLOW, timeout_s, (tcb_noid_t)callback, id);
+}
+
+static inline bool systimer_slow_renew(u16 timeout_s, tcb_noid_t callback)
+{
+    return _systimer_renew(SYS_DOMAIN_SLOW, timeout_s, callback, -1);
+}
+
+static inline bool systimer_slow_renew_task(u16 timeout_s, tcb_id_t callback, int id)
+{
+    return _systimer_renew(SYS_DOMAIN_SLOW, timeout_s, (tcb_noid_t)callback, id);
+}
+
+static inline void systimer_slow_delete(tcb_noid_t callback)
+{
+    _systimer_renew(SYS_DOMAIN_SLOW, 0, callback, -1);
+}
+
+static inline void systimer_slow_delete_task(tcb_id_t callback, int id)
+{
+    _systimer_renew(SYS_DOMAIN_SLOW, 0, (tcb_noid_t)callback, id);
+}
+
+static inline bool systimer_slow_is_running(tcb_noid_t callback)
+{
+    return _systimer_is_running(SYS_DOMAIN_SLOW, callback, -1);
+}
+
+static inline bool systimer_slow_is_running_task(tcb_id_t callback, int id)
+{
+    return _systimer_is_running(SYS_DOMAIN_SLOW, (tcb_noid_t)callback, id);
+}
+
+#ifdef SYS_TIMER_PERIODIC
+/* The period is in seconds, which is an exact number of ticks */
+static inline bool systimer_slow_new_periodic(u16 period_s, tcb_periodic_t callback, int id)
+{
+    return _systimer_new_periodic(SYS_DOMAIN_SLOW, period_s, (tcb_noid_t)callback, id);
+}
+
+static inline void systimer_slow_delete_periodic(tcb_periodic_t callback, int id)
+{
+    _systimer_renew(SYS_DOMAIN_SLOW, 0, (tcb_noid_t)callback, id);
+}
+#endif
+#endif /* SYS_SLOW_DOMAIN */
+
+#ifdef SYS_TIMER_STATS
+/* Number of bins in the lateness histogram: bin 0 counts the timers that
+ * expired on time, bin n counts lateness of [2^(n-1), 2^n) ticks and the last
+ * bin also counts everything above it */
+#define SYS_STATS_LATE_BINS 8
+
+typedef struct systimer_stats {
+	u16 active;       // currently running timers
+	u16 peak;         // high-water mark of active timers
+	u16 alloc_fail;   // times the fail_callback was called
+	u16 late[SYS_STATS_LATE_BINS];  // expiry lateness histogram
+	u16 calls_max;    // most callbacks run by a single tick event
+	u32 calls;        // callbacks run in total
+	u32 ticks;        // tick events handled in total
+} systimer_stats_t;
+
+/* Copies the statistics of the domain. The counters saturate, except for
+ * calls and ticks that are meant to be compared with each other */
+void systimer_stats_get(sys_domain_t dom, systimer_stats_t *stats);
+/* Clears everything but the active timer count, peak restarts from it */
+void systimer_stats_reset(sys_domain_t dom);
+/* Fills calls with the callbacks that currently hold a slot in the domain's
+ * pool, returns how many are written (at most max) */
+uint systimer_stats_owners(sys_domain_t dom, tcb_noid_t *calls, uint max);
+#endif
+
+#ifdef SYS_TIMER_GROUPS
+/* Groups are bit flags, so a timer can be a member of several groups and the
+ * group functions can act on several groups at once: SYS_GROUP(0)..SYS_GROUP(6) */
+#define SYS_GROUP(n)    ((u8)1 << (n))
+#define SYS_GROUP_ALL   0x7F
+
+bool _systimer_group_tag(sys_domain_t dom, tcb_noid_t callback, int id, u8 groups);
+
+/* - A timer is tagged after it is created, the tags are cleared when the timer
+ *   ends. Tagging returns False if the timer is not running.
+ * - The group functions act on all the domains in one pass with the interrupts
+ *   disabled, so a power-state transition is seen atomically by the ISRs.
+ * - A suspended timer keeps its remaining time and its slot, is_running still
+ *   returns True for it. Renewing it changes the remaining time, it stays
+ *   suspended until resumed.
+ * - Don't call these from an isr or from a timer callback.
+ */
+static inline bool systimer_group_tag(tcb_noid_t callback, u8 groups)
+{
+    return _systimer_group_tag(SYS_DOMAIN_FAST, callback, -1, groups);
+}
+
+static inline bool systimer_group_tag_task(tcb_id_t callback, int id, u8 groups)
+{
+    return _systimer_group_tag(SYS_DOMAIN_FAST, (tcb_noid_t)callback, id, groups);
+}
+
+#ifdef SYS_TIMER_PERIODIC
+static inline bool systimer_group_tag_periodic(tcb_periodic_t callback, int id, u8 groups)
+{
+    return _systimer_group_tag(SYS_DOMAIN_FAST, (tcb_noid_t)callback, id, groups);
+}
+#endif
+
+#ifdef SYS_SLOW_DOMAIN
+static inline bool systimer_slow_group_tag(tcb_noid_t callback, u8 groups)
+{
+    return _systimer_group_tag(SYS_DOMAIN_SLOW, callback, -1, groups);
+}
+
+static inline bool systimer_slow_group_tag_task(tcb_id_t callback, int id, u8 groups)
+{
+    return _systimer_group_tag(SYS_DOMAIN_SLOW, (tcb_noid_t)callback, id, groups);
+}
+#endif
+
+/* Pauses the running timers that are members of any of the groups */
+void systimer_group_suspend(u8 groups);
+/* Restarts the suspended members of the groups with their remaining time */
+void systimer_group_resume(u8 groups);
+/* Deletes all the members of the groups, suspended or not */
+void systimer_group_cancel(u8 groups);
+#endif
+
+#ifdef SYS_TIMER_CHECKPOINT
+/* A timer instance in a form that survives a reset, the deadline is turned
+ * into the remaining time in the ticks of its domain */
+typedef struct systimer_record {
+	tcb_noid_t call;
+	int        id;
+	u16        remaining;
+	u8         domain;
+	u8         group;
+	u16        period;
+	u16        frac;
+	u16        frac_acc;
+} systimer_record_t;
+
+/* Saves the running timers of all domains into records, returns the count or
+ * -1 if they don't fit or if called from a timer callback. The earliest
+ * deadline of the timers that are not suspended is written to earliest in
+ * 1/SYS_TICK_IN_SEC seconds, 0 if there is none. Call with the interrupts
+ * disabled. */
+int _systimer_save(systimer_record_t *records, uint max, u32 *earliest);
+/* Rebuilds the saved timers after systimer_init, elapsed is the time passed
+ * since the save in 1/SYS_TICK_IN_SEC seconds. Timers that expired in the
+ * meantime are called on the next tick. */
+void _systimer_restore(const systimer_record_t *records, uint count, u32 elapsed);
+#endif
+
 /****************************************************************************/
 /* Just a convenient macro, that is used by the module */
 #define _uninterrupted(codeline)               \
@@ -0,0 +1,73 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef TOPIC_H
+#define TOPIC_H
+
+#include "types.h"
+#include "event.h"
+
+/***************************** READ FIRST ***********************************/
+/* Publish/subscribe on top of the events.
+ * - A subscriber is an event with its own handler. A topic holds the mask of
+ *   its subscriber events, publishing ORs the mask into the pending events:
+ *   the fan-out to any number of handlers is one instruction, also in an isr.
+ * - A topic can carry a payload of a fixed size. topic_publish_payload keeps
+ *   two snapshots and switches to the new one after copying, so a subscriber
+ *   sees a whole payload. topic_read copies the latest one consistently,
+ *   topic_payload gives it in place, valid until the publish after next.
+ * - A payload topic should have one publisher.
+ */
+/****************************************************************************/
+
+typedef struct topic {
+	volatile event_reg_t  subscribers;
+	u8                   *buf;        // two snapshots
+	u16                   size;
+	volatile u8           latest;     // index of the latest snapshot
+	volatile u16          seq;        // incremented on every payload publish
+} topic_t;
+
+#define TOPIC_DEFINE(name) \
+	topic_t name = {0, Null, 0, 0, 0}
+
+#define TOPIC_DEFINE_PAYLOAD(name, type) \
+	static u8 name##_buf[2 * sizeof(type)]; \
+	topic_t name = {0, name##_buf, sizeof(type), 0, 0}
+
+/* The event's handler is called after every publish of the topic */
+void topic_subscribe(topic_t *topic, event_id_t id);
+void topic_unsubscribe(topic_t *topic, event_id_t id);
+
+/* The same without tracing */
+static inline void _topic_publish(const topic_t *topic)
+{
+	extern volatile event_reg_t event_list;
+	event_list |= topic->subscribers;
+}
+
+/* Recorded by the trace like event_set_traced, a record per subscriber */
+static inline void topic_publish(const topic_t *topic)
+{
+	trace_events(topic->subscribers);
+	_topic_publish(topic);
+}
+
+#define topic_publish_isr(topic) do \
+	{	trace_isr_events((topic)->subscribers); \
+		_topic_publish(topic); \
+		__bic_SR_register_on_exit(LPM4_bits); \
+	} while (0)
+
+/* Copies the payload into the free snapshot, makes it the latest and
+ * publishes. From an isr, wake up with __bic_SR_register_on_exit after it. */
+void topic_publish_payload(topic_t *topic, const void *payload);
+/* Copies the latest payload, returns the sequence number it was published with */
+u16 topic_read(const topic_t *topic, void *payload);
+
+static inline const void *topic_payload(const topic_t *topic)
+{
+	return topic->buf + (topic->latest ? topic->size : 0);
+}
+
+#endif /* TOPIC_H */
@@ -0,0 +1,89 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "types.h"
+
+/**************************   MODIFY   **************************************/
+/* Define to record the ISR originated events and timers, see READ FIRST */
+// #define TRACE_ENABLE
+/* Size of the trace ring buffer, should be a power of 2 */
+#define TRACE_BUFFER_SIZE 256
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* Records every event_set_isr, event_set_traced and systimer_new_isr(and
+ * their variants) with a timestamp, into a compact binary stream. tools/replay feeds the stream
+ * back into the event machine and the systimer compiled for the host.
+ * - The timestamps are in ACLK ticks, counted by TA0 in continuous mode. TA0
+ *   and its TIMER0_A1 vector belong to this module, so it can't be used with
+ *   UART_RX_FRAME_MODE.
+ * - The systimer ticks are not recorded, the replay generates its own.
+ * - The drivers set their events with event_set_traced where an ISR or a DMA
+ *   handler can reach them, so some are recorded from the main context too.
+ *   A topic publish is recorded as an event record per subscriber.
+ * - The stream is a sequence of 16 bit little endian words. Every record
+ *   starts with the ACLK ticks since the previous record and a type word:
+ *     TRACE_GAP:   the next record is 65536 * delta ticks later in addition
+ *     TRACE_EVENT: the low 12 bits are the event id
+ *     TRACE_TIMER: the low 12 bits are the domain, followed by the timeout,
+ *                  the callback address and the id
+ *     TRACE_DROP:  the low 12 bits are the number of records lost before
+ *   The callback address is 16 bits, so the small code model is assumed.
+ * - Take the stream out with trace_read and store or send it as it is, e.g.
+ *   with uart_write.
+ */
+/****************************************************************************/
+
+#define TRACE_GAP   0x0000
+#define TRACE_EVENT 0x1000
+#define TRACE_TIMER 0x2000
+#define TRACE_DROP  0x3000
+#define TRACE_TYPE_MASK 0xF000
+
+#ifdef TRACE_ENABLE
+
+void trace_init(void);
+/* Copies at most length bytes of the stream, returns the amount copied */
+u16 trace_read(void *data, u16 length);
+u16 trace_count(void);
+
+void _trace_event(uint id);
+/* The same from any context, disables the interrupts around the record */
+void trace_event(uint id);
+/* A record per set bit of the event mask, for the topic publishes */
+void _trace_events(uint mask);
+void trace_events(uint mask);
+void _trace_timer(uint domain, u16 timeout, pfn_t callback, int id);
+
+/* Called from the _isr functions, with the interrupts disabled */
+static inline void trace_isr_event(uint id) { _trace_event(id); }
+static inline void trace_isr_events(uint mask) { _trace_events(mask); }
+static inline void trace_isr_timer(uint domain, u16 timeout, pfn_t callback, int id)
+{
+	_trace_timer(domain, timeout, callback, id);
+}
+
+#else
+
+static inline void trace_event(uint id) {}
+static inline void trace_events(uint mask) {}
+static inline void trace_isr_event(uint id) {}
+static inline void trace_isr_events(uint mask) {}
+static inline void trace_isr_timer(uint domain, u16 timeout, pfn_t callback, int id) {}
+
+#endif /* TRACE_ENABLE */
+
+/* The host tools, tools/replay and tools/energy, hook the dispatches with
+ * these, nothing on the device */
+#ifdef EVM_REPLAY
+void trace_dispatch_begin(uint id);
+void trace_dispatch_end(uint id);
+#else
+static inline void trace_dispatch_begin(uint id) {}
+static inline void trace_dispatch_end(uint id) {}
+#endif
+
+#endif /* TRACE_H */
@@ -0,0 +1,123 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef UART_H
+#define UART_H
+
+#include "types.h"
+#include "event.h"
+
+/**************************   MODIFY   **************************************/
+/* SMCLK frequency and the baud rate, the divider is calculated from these */
+#define UART_CLOCK_HZ       20971520
+#define UART_BAUD_RATE      115200
+/* Sizes of the receive and transmit ring buffers, should be powers of 2 */
+#define UART_RX_BUFFER_SIZE 64
+#define UART_TX_BUFFER_SIZE 64
+/* Maximum number of uart_submit requests waiting or being sent, a power of 2 */
+#define UART_TX_QUEUE       4
+/* The DMA fills the rx ring in blocks of at most this size, the cpu wakes up
+ * once per block */
+#define UART_RX_BLOCK_SIZE  16
+/* A partially filled block is flushed after the line is idle this long */
+#define UART_RX_IDLE_MS     5
+/* Define to receive whole frames separated by idle gaps instead of blocks,
+ * see READ FIRST */
+// #define UART_RX_FRAME_MODE
+/* In frame mode, the idle time that ends a frame in bit times(35 = 3.5 chars)
+ * and the number of frames that can wait in the rx ring(a power of 2) */
+#define UART_FRAME_GAP_BITS 35
+#define UART_FRAME_QUEUE    4
+/* DMA trigger numbers of UCA2RXIFG and UCA2TXIFG, these are device specific,
+ * look them up in the datasheet. The receiver uses the DMA channel 0 and the
+ * transmitter uses the channel 1 */
+#define UART_DMA_RX_TRIGGER 20
+#define UART_DMA_TX_TRIGGER 21
+/****************************************************************************/
+
+/***************************** READ FIRST ***********************************/
+/* A UART driver on eUSCI_A2 that moves the data with the DMA controller, so
+ * the cpu is not involved per character.
+ * - EVENT_UART_RX and EVENT_UART_TX_END should be defined in user_events.h,
+ *   register your own handlers for them.
+ * - The DMA writes the received data directly into the rx ring. EVENT_UART_RX
+ *   is set when a block is full, or when the line goes idle after a partial
+ *   block. If the ring gets full, the receiver stops until it is read.
+ * - uart_write copies into the tx ring, uart_send sends directly from the
+ *   caller's buffer which should stay untouched until EVENT_UART_TX_END.
+ *   EVENT_UART_TX_END is also set when the transmitter runs out of data.
+ * - uart_submit queues a request of scatter-gather segments, nothing is
+ *   copied. The segments are sent in order and back to back, then the request
+ *   is marked as not busy and its own event is set. The request, its iov array
+ *   and the data should stay untouched while it is busy.
+ * - The sources are served in this order whenever the DMA is free: the
+ *   uart_send buffer, the requests, the tx ring. A segment that started is
+ *   never interrupted.
+ * - The port pins and the clocks are configured by the application.
+ *
+ * Frame mode(UART_RX_FRAME_MODE):
+ * - The rx DMA and the idle poll are not used. The rx ISR stores the char into
+ *   the rx ring and restarts TA0, that is all the per char work. When the line
+ *   is idle for UART_FRAME_GAP_BITS, TA0 closes the frame and EVENT_UART_RX is
+ *   set once for the whole frame. TA0 runs from ACLK, the gap resolution is
+ *   ~30us.
+ * - Read with the uart_frame_ functions only, uart_read and the peek/commit
+ *   pair are not available. Chars that don't fit the rx ring are dropped and
+ *   counted as overruns, as are the boundaries that don't fit the queue.
+ */
+/****************************************************************************/
+
+typedef struct uart_iov {
+	const void *data;
+	u16         length;
+} uart_iov_t;
+
+typedef struct uart_tx_request {
+	const uart_iov_t *iov;
+	u8                count;     // number of segments in iov
+	event_id_t        event;     // set when the request is sent
+	volatile bool     busy;      // True from the submit until sent
+} uart_tx_request_t;
+
+void uart_init(void);
+/* Recalculates the baud rate dividers after SMCLK is changed(UART_CLOCK_HZ is
+ * only the initial clock). A char that is on the line meanwhile is lost. */
+void uart_set_clock(u32 hz);
+
+#ifdef UART_RX_FRAME_MODE
+/* Length of the oldest received frame, 0 if there is none */
+u16 uart_frame_length(void);
+/* Copies the oldest frame and removes it, at most size bytes are copied and
+ * the rest of the frame is dropped. Returns the amount copied, 0 if there is
+ * no frame */
+u16 uart_frame_read(void *data, u16 size);
+/* Number of received frames waiting */
+u16 uart_frame_count(void);
+#else
+/* Copies at most length received bytes, returns the amount copied */
+u16 uart_read(void *data, u16 length);
+/* Zero-copy reading, see ring_peek_read */
+u16 uart_rx_peek(const u8 **data);
+void uart_rx_commit(u16 length);
+#endif
+u16 uart_rx_count(void);
+/* Number of times the receiver stopped because the rx ring was full, in frame
+ * mode the number of chars and boundaries dropped */
+u16 uart_rx_overruns(void);
+
+/* Copies as much as fits into the tx ring, returns the amount copied */
+u16 uart_write(const void *data, u16 length);
+/* Sends the buffer without copying, returns False if the previous uart_send
+ * buffer is not sent yet */
+bool uart_send(const void *data, u16 length);
+bool uart_tx_busy(void);
+/* Free space in the tx ring, the most that uart_write can take now */
+u16 uart_tx_space(void);
+
+/* Queues the request, returns False if UART_TX_QUEUE requests are already
+ * waiting. The request's event is set when all of its segments are sent. */
+bool uart_submit(uart_tx_request_t *request);
+/* Number of requests that can be submitted now */
+uint uart_tx_slots(void);
+
+#endif /* UART_H */
@@ -0,0 +1,14 @@
+#ifndef USER_INPUTS_H
+#define USER_INPUTS_H
+
+/* One line per input, see mspio.h:
+ * X(ctx, id, port, pin, pull, debounce_ms, longpress_ms, on_change, on_longpress)
+ */
+#define MSPIO_INPUTS(X, ctx) \
+	X(ctx, INPUT_0, 1, BIT0, MSPIO_PULLUP, 50, 0, Null, Null)
+
+/* The ports that have inputs, one ISR is generated for each */
+#define MSPIO_PORTS(X) \
+	X(1)
+
+#endif
@@ -0,0 +1,63 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/log.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/uart.h"
+#include "include/ring.h"
+#include <msp430.h>
+
+#define LOG_RETRY_MS 10
+
+RING_DEFINE(log_ring, LOG_BUFFER_SIZE);
+
+static u16 dropped;
+// The part of the ring being sent, it is released when the request ends
+static uart_iov_t log_iov;
+static uart_tx_request_t log_request = {&log_iov, 1, EVENT_LOG, False};
+
+void _log_write(const u16 *record, u16 size)
+{
+	u16 dropped_record[2] = {LOG_ID_DROPPED, 0};
+
+	_uninterrupted(
+		if (dropped && ring_space(&log_ring) >= sizeof(dropped_record) + size) {
+			dropped_record[1] = dropped;
+			ring_write(&log_ring, dropped_record, sizeof(dropped_record));
+			dropped = 0;
+		}
+		if (0 == dropped && ring_space(&log_ring) >= size)
+			ring_write(&log_ring, record, size);
+		else
+			++dropped;
+	);
+	event_set_traced(EVENT_LOG);
+}
+
+/* Runs on EVENT_LOG, which is also the completion event of the request. So
+ * the next part is sent as soon as the previous one is done. */
+static void log_drain(void)
+{
+	const u8 *data;
+
+	if (log_request.busy)
+		return;
+
+	ring_commit_read(&log_ring, log_iov.length);
+	log_iov.length = ring_peek_read(&log_ring, &data);
+	log_iov.data = data;
+	if (log_iov.length && !uart_submit(&log_request)) {
+		// The uart queue is full, try again later
+		log_iov.length = 0;
+		systimer_renew(LOG_RETRY_MS, log_drain);
+	}
+}
+
+void log_init(void)
+{
+	ring_clear(&log_ring);
+	log_iov.length = 0;
+	dropped = 0;
+	event_register(EVENT_LOG, log_drain);
+}
@@ -0,0 +1,180 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/lpm5.h"
+#include "include/event.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#ifndef SYS_TIMER_CHECKPOINT
+#error "lpm5 needs SYS_TIMER_CHECKPOINT defined in systimer.h"
+#endif
+
+#define LPM5_MAGIC 0x4C35
+
+typedef struct lpm5_checkpoint {
+	u16               magic;
+	u16               image;     // identifies the firmware that wrote it
+	uint              lpm;
+	u32               preset;    // RTC counter value at the save
+	u16               count;
+	systimer_record_t timer[LPM5_MAX_TIMERS];
+	u16               check;     // checksum of everything above
+} lpm5_checkpoint_t;
+
+/* The checkpoint has to survive the loss of RAM. On FRAM devices PERSISTENT
+ * keeps it in FRAM, for a backup RAM change it to a DATA_SECTION placed there */
+#pragma PERSISTENT(checkpoint)
+static lpm5_checkpoint_t checkpoint = {0};
+
+// Changes with every build of this file and with the code layout
+static const char build[] = __DATE__ " " __TIME__;
+
+/******************************* HARDWARE ***********************************/
+/* The RTC_C counter mode counts ACLK/32 = 1024Hz, the same as SYS_TICK_IN_SEC.
+ * It is preset so that the 32 bit overflow event falls on the deadline. */
+static void rtc_program(u32 preset)
+{
+	RTCCTL0_H = RTCKEY_H;
+	RTCCTL13 = RTCHOLD | RTCSSEL_2 | RTCTEV_3;
+	RTCPS1CTL = RT1SSEL_0 | RT1PSDIV_4;
+	RTCNT12 = (u16)preset;
+	RTCNT34 = (u16)(preset >> 16);
+	RTCCTL0_L = RTCTEVIE;
+	RTCCTL13 &= ~RTCHOLD;
+	RTCCTL0_H = 0;
+}
+
+static u32 rtc_stop(void)
+{
+	u32 count;
+
+	RTCCTL0_H = RTCKEY_H;
+	RTCCTL13 |= RTCHOLD;
+	RTCCTL0_L &= ~(RTCTEVIE | RTCTEVIFG);
+	count = RTCNT12 | ((u32)RTCNT34 << 16);
+	RTCCTL0_H = 0;
+	return count;
+}
+
+static inline void regulator_off(void)
+{
+	PMMCTL0_H = PMMPW_H;
+	PMMCTL0_L |= PMMREGOFF;
+	PMMCTL0_H = 0;
+}
+
+static inline void regulator_on(void)
+{
+	PMMCTL0_H = PMMPW_H;
+	PMMCTL0_L &= ~PMMREGOFF;
+	PMMCTL0_H = 0;
+}
+
+static inline bool is_lpm5_wakeup(void)
+{
+	bool wakeup = (PMMIFG & PMMLPM5IFG) ? True : False;
+
+	PMMCTL0_H = PMMPW_H;
+	PMMIFG &= ~PMMLPM5IFG;
+	PMMCTL0_H = 0;
+	return wakeup;
+}
+/****************************************************************************/
+
+static u16 checksum(const void *data, size_t size, u16 sum)
+{
+	const u8 *bytes = data;
+
+	// Rotate and add, cheap and order sensitive
+	while (size--) {
+		sum += *bytes++;
+		sum = (sum << 1) | (sum >> 15);
+	}
+	return sum;
+}
+
+static u16 image_id(void)
+{
+	return checksum(build, sizeof(build), (u16)(uintptr_t)lpm5_restore);
+}
+
+static u16 checkpoint_sum(void)
+{
+	return checksum(&checkpoint, offsetof(lpm5_checkpoint_t, check), 0);
+}
+
+bool lpm5_sleep(void)
+{
+	extern volatile event_reg_t event_list;
+	extern volatile uint event_lpm;
+	uint state = __get_interrupt_state();
+	int count;
+	u32 earliest;
+	uint lpm;
+
+	__disable_interrupt();
+
+	// A pending event would wait for the next wake-up, dispatch it first
+	if (event_list) {
+		__set_interrupt_state(state);
+		return False;
+	}
+
+	count = _systimer_save(checkpoint.timer, LPM5_MAX_TIMERS, &earliest);
+	if (count < 0) {
+		// increase LPM5_MAX_TIMERS, or called from a timer callback
+		__set_interrupt_state(state);
+		return False;
+	}
+
+	checkpoint.magic = LPM5_MAGIC;
+	checkpoint.image = image_id();
+	checkpoint.lpm = event_lpm;
+	checkpoint.count = count;
+	checkpoint.preset = earliest ? 0 - earliest : 0;
+	checkpoint.check = checkpoint_sum();
+
+	if (earliest) {
+		rtc_program(checkpoint.preset);
+		lpm = LPM3_bits;
+	} else {
+		lpm = LPM4_bits;
+	}
+
+	regulator_off();
+	__bis_SR_register(lpm | GIE);
+
+	// An interrupt came in on the way, we are still in the same RAM context
+	__disable_interrupt();
+	regulator_on();
+	if (earliest)
+		rtc_stop();
+	checkpoint.magic = 0;
+	__set_interrupt_state(state);
+	return False;
+}
+
+bool lpm5_restore(void)
+{
+	u32 elapsed = 0;
+	bool restored = False;
+
+	if (is_lpm5_wakeup() && LPM5_MAGIC == checkpoint.magic
+	    && image_id() == checkpoint.image
+	    && checkpoint_sum() == checkpoint.check
+	    && checkpoint.count <= LPM5_MAX_TIMERS) {
+		// The counter was preset to the negative of the deadline
+		if (checkpoint.preset)
+			elapsed = rtc_stop() - checkpoint.preset;
+
+		_systimer_restore(checkpoint.timer, checkpoint.count, elapsed);
+		event_lpm_set((event_lpm_t)checkpoint.lpm);
+		restored = True;
+	}
+
+	// A checkpoint is restored only once
+	checkpoint.magic = 0;
+	PM5CTL0 &= ~LOCKLPM5;
+	return restored;
+}
@@ -0,0 +1,184 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/mspio.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#define P_IN_BASE   0x00
+#define P_OUT_BASE  0x02
+#define P_DIR_BASE  0x04
+#define P_REN_BASE  0x06
+#define P_IES_BASE  0x18
+#define P_IE_BASE   0x1A
+#define P_IFG_BASE  0x1C
+
+#define PxIN(base)      *((volatile u8*)(base) + P_IN_BASE)
+#define PxOUT(base)     *((volatile u8*)(base) + P_OUT_BASE)
+#define PxDIR(base)     *((volatile u8*)(base) + P_DIR_BASE)
+#define PxREN(base)     *((volatile u8*)(base) + P_REN_BASE)
+#define PxIES(base)     *((volatile u8*)(base) + P_IES_BASE)
+#define PxIE(base)      *((volatile u8*)(base) + P_IE_BASE)
+#define PxIFG(base)     *((volatile u8*)(base) + P_IFG_BASE)
+
+typedef struct mspio_input {
+	volatile u8      *port_base;
+	u8                pin;
+	u8                pull;
+	u16               debounce;
+	u16               longpress;
+	mspio_callback_t  on_change;
+	mspio_callback_t  on_longpress;
+} mspio_input_t;
+
+#define INPUT_ENTRY(ctx, id, port, pin, pull, debounce, longpress, on_change, on_longpress) \
+	{&P##port##IN, pin, pull, debounce, longpress, on_change, on_longpress},
+
+static const mspio_input_t input_table[MSPIO_INPUT_COUNT] = {
+	MSPIO_INPUTS(INPUT_ENTRY, ~)
+};
+
+static u8 input_states[MSPIO_INPUT_COUNT];
+
+/* The lookup tables are built by the preprocessor: the entry of bit b of port
+ * n is the sum over the inputs of (id + 1) if the input is on that pin, so
+ * it is id + 1 of the only match or 0, minus 1 gives -1 for no input */
+#define LUT_PORT(port, bit) port
+#define LUT_BIT(port, bit) bit
+#define LUT_MATCH(ctx, id, port, pin, ...) \
+	+ (((port) == (LUT_PORT ctx) && (pin) == (1 << (LUT_BIT ctx))) ? MSPIO_##id + 1 : 0)
+#define LUT_ENTRY(port, bit) ((0 MSPIO_INPUTS(LUT_MATCH, (port, bit))) - 1)
+
+/******************************* HARDWARE ***********************************/
+static inline void pin_set_pull_dir(const mspio_input_t *in)
+{
+	if (MSPIO_PULLUP == in->pull)
+		PxOUT(in->port_base) |= in->pin;
+	else if (MSPIO_PULLDOWN == in->pull)
+		PxOUT(in->port_base) &= ~in->pin;
+}
+
+static inline void pin_enable_pull(const mspio_input_t *in)
+{
+	if (MSPIO_FLOATING != in->pull) {
+		PxREN(in->port_base) |= in->pin;
+		__delay_cycles(MSPIO_PULL_CHARGE_DELAY);
+	}
+}
+
+static inline void pin_disable_pull(const mspio_input_t *in)
+{
+	PxREN(in->port_base) &= ~in->pin;
+}
+/****************************************************************************/
+
+static u16 on_longpress(int id, u16 latency)
+{
+	const mspio_input_t *current = &input_table[id];
+
+	if (Null != current->on_longpress)
+		current->on_longpress(input_states[id]);
+	return 0;
+}
+
+static u16 on_debounce_end(int id, u16 latency)
+{
+	const mspio_input_t *current = &input_table[id];
+	volatile u8 *base = current->port_base;
+	u8 pin = current->pin;
+	u8 state;
+
+	pin_enable_pull(current);
+
+	if (PxIN(base) & pin) {
+		state = 1;
+		PxIES(base) |= pin;
+	} else {
+		state = 0;
+		PxIES(base) &= ~pin;
+	}
+
+	PxIFG(base) &= ~pin;
+	// If state has changed during edge transition, leave it for the ISR to decide
+	if ((PxIN(base) & pin ? 1 : 0) != state) {
+		PxIFG(base) |= pin;
+		PxIE(base) |= pin;
+		return 0;
+	}
+	// To decrease current consumption disable the pull resistor if the
+	// input is pulling the reverse way
+	if ((state && MSPIO_PULLDOWN == current->pull)
+	    || (!state && MSPIO_PULLUP == current->pull))
+		pin_disable_pull(current);
+
+	// Only register change if it is different than the previous one
+	if (input_states[id] != state) {
+		input_states[id] = state;
+		if (Null != current->on_change)
+			current->on_change(state);
+		// The longpress works for both states: 0 and 1
+		if (current->longpress)
+			systimer_renew_task(current->longpress, on_longpress, id);
+	}
+
+	PxIE(base) |= pin;
+	return 0;
+}
+
+void mspio_init(void)
+{
+	uint i;
+
+	for (i = 0; i < MSPIO_INPUT_COUNT; i++) {
+		const mspio_input_t *current = &input_table[i];
+
+		PxDIR(current->port_base) &= ~current->pin;
+		pin_set_pull_dir(current);
+		pin_enable_pull(current);
+		// Sample input for the initial state
+		input_states[i] = PxIN(current->port_base) & current->pin ? 1 : 0;
+		// Debounce 1ms for the initial state, and let the other initializations be
+		// done automatically after the end of debounce
+		systimer_new_task(1, on_debounce_end, i);
+	}
+}
+
+uint mspio_state(mspio_input_id_t id)
+{
+	assert(id < MSPIO_INPUT_COUNT);
+	return input_states[id];
+}
+
+/* During the debounce period:
+ * - Disable pullup/pulldown to decrease current consumption
+ * - Disable individual interrupt enable bit to prevent triggering
+ *   of further interrupts
+ */
+static inline void enter_debounce_isr(uint id)
+{
+	const mspio_input_t *current = &input_table[id];
+
+	pin_disable_pull(current);
+	PxIE(current->port_base) &= ~current->pin;
+	systimer_new_task_isr(current->debounce, on_debounce_end, id);
+}
+
+#define MSPIO_PRAGMA(x) _Pragma(#x)
+
+/* PxIV is 0 for no interrupt and 2 * (bit + 1) for a pin, the lookup table
+ * is indexed with PxIV / 2 */
+#define PORT_ISR(n) \
+	static const s8 port##n##_lut[9] = { \
+		-1, LUT_ENTRY(n, 0), LUT_ENTRY(n, 1), LUT_ENTRY(n, 2), LUT_ENTRY(n, 3), \
+		LUT_ENTRY(n, 4), LUT_ENTRY(n, 5), LUT_ENTRY(n, 6), LUT_ENTRY(n, 7) \
+	}; \
+	MSPIO_PRAGMA(vector = PORT##n##_VECTOR) \
+	__interrupt void PORT##n##_ISR(void) \
+	{ \
+		int id = port##n##_lut[__even_in_range(P##n##IV, 0x10) >> 1]; \
+		if (id >= 0) \
+			enter_debounce_isr(id); \
+	}
+
+MSPIO_PORTS(PORT_ISR)
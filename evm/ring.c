@@ -0,0 +1,77 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/ring.h"
+#include "include/debug.h"
+#include <string.h>
+
+void ring_init(ring_t *ring, u8 *buf, u16 size)
+{
+	assert(size && !(size & (size - 1)));
+
+	ring->buf = buf;
+	ring->mask = size - 1;
+	ring->head = 0;
+	ring->tail = 0;
+}
+
+u16 ring_write(ring_t *ring, const void *data, u16 length)
+{
+	u16 head = ring->head;
+	u16 index = head & ring->mask;
+	u16 space = ring_space(ring);
+	u16 first;
+
+	if (length > space)
+		length = space;
+
+	first = ring->mask + 1 - index;
+	if (first > length)
+		first = length;
+
+	memcpy(ring->buf + index, data, first);
+	memcpy(ring->buf, (const u8 *)data + first, length - first);
+	// The data should be in place before the consumer can see it
+	ring->head = head + length;
+	return length;
+}
+
+u16 ring_read(ring_t *ring, void *data, u16 length)
+{
+	u16 tail = ring->tail;
+	u16 index = tail & ring->mask;
+	u16 count = ring->head - tail;
+	u16 first;
+
+	if (length > count)
+		length = count;
+
+	first = ring->mask + 1 - index;
+	if (first > length)
+		first = length;
+
+	memcpy(data, ring->buf + index, first);
+	memcpy((u8 *)data + first, ring->buf, length - first);
+	ring->tail = tail + length;
+	return length;
+}
+
+u16 ring_peek_write(const ring_t *ring, u8 **data)
+{
+	u16 index = ring->head & ring->mask;
+	u16 space = ring_space(ring);
+	u16 contiguous = ring->mask + 1 - index;
+
+	*data = ring->buf + index;
+	return space < contiguous ? space : contiguous;
+}
+
+u16 ring_peek_read(const ring_t *ring, const u8 **data)
+{
+	u16 index = ring->tail & ring->mask;
+	u16 count = ring_count(ring);
+	u16 contiguous = ring->mask + 1 - index;
+
+	*data = ring->buf + index;
+	return count < contiguous ? count : contiguous;
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/spi.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+typedef char queue_size_check[(SPI_QUEUE & (SPI_QUEUE - 1)) ? -1 : 1];
+
+// Submitted transfers, the one at queue_tail is on the bus
+static spi_transfer_t *queue[SPI_QUEUE];
+static volatile u8 queue_head;
+static volatile u8 queue_tail;
+// Bytes of the transfer on the bus that are sent, only used by the ISR
+static u16 position;
+
+static inline spi_transfer_t *current(void)
+{
+	return queue[queue_tail & (SPI_QUEUE - 1)];
+}
+
+// The byte at position, written or dummy
+static inline u8 next_byte(const spi_transfer_t *t)
+{
+	return (position < t->write_length) ? t->write[position] : SPI_DUMMY;
+}
+
+// Don't use with interrupts enabled
+static void transfer_start(void)
+{
+	spi_transfer_t *t;
+
+	if (queue_tail == queue_head)
+		return;
+
+	t = current();
+	position = 0;
+	*t->cs_port &= ~t->cs_pin;
+	// One byte at a time, the rx interrupt sends the next
+	UCB1TXBUF = next_byte(t);
+}
+
+static void transfer_end(void)
+{
+	spi_transfer_t *t = current();
+
+	*t->cs_port |= t->cs_pin;
+	++queue_tail;
+	t->busy = False;
+	event_set_traced(t->event);
+	transfer_start();
+}
+
+void spi_init(void)
+{
+	UCB1CTLW0 = UCSWRST;
+	UCB1CTLW0 |= SPI_MODE | UCMSB | UCMST | UCMODE_0 | UCSYNC | UCSSEL__SMCLK;
+	UCB1BRW = SPI_CLOCK_HZ / SPI_BUS_HZ;
+	UCB1CTLW0 &= ~UCSWRST;
+	UCB1IE = UCRXIE;
+
+	queue_tail = queue_head;
+}
+
+bool spi_submit(spi_transfer_t *transfer)
+{
+	bool accepted = False;
+
+	assert(transfer->write_length || transfer->read_length);
+
+	_uninterrupted(
+		if ((u8)(queue_head - queue_tail) < SPI_QUEUE) {
+			transfer->busy = True;
+			queue[queue_head & (SPI_QUEUE - 1)] = transfer;
+			// Only start if the bus was idle
+			if (queue_head++ == queue_tail)
+				transfer_start();
+			accepted = True;
+		}
+	);
+	return accepted;
+}
+
+uint spi_slots(void)
+{
+	return SPI_QUEUE - (u8)(queue_head - queue_tail);
+}
+
+#pragma vector = USCI_B1_VECTOR
+__interrupt void USCI_B1_ISR(void)
+{
+	spi_transfer_t *t;
+	u8 data;
+
+	switch (__even_in_range(UCB1IV, 4)) {
+		case 2:  // rx, the byte at position is complete
+			t = current();
+			data = UCB1RXBUF;
+			if (position >= t->write_length)
+				t->read[position - t->write_length] = data;
+
+			if (++position < t->write_length + t->read_length) {
+				UCB1TXBUF = next_byte(t);
+			} else {
+				transfer_end();
+				__bic_SR_register_on_exit(LPM4_bits);
+			}
+			break;
+		default: break;
+	}
+}
@@ -0,0 +1,67 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/supervisor.h"
+#include "include/event.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#ifdef SUPERVISOR_ENABLE
+
+#define SUPERVISOR_MAGIC 0x5356
+
+// Has to survive the watchdog reset, the startup code should not clear it
+#pragma NOINIT(supervisor_now)
+supervisor_record_t supervisor_now;
+u8 supervisor_budget[EVENT_COUNT];
+
+static supervisor_record_t last;
+
+bool supervisor_init(void)
+{
+	bool timeout = False;
+	uint cause;
+	uint i;
+
+	WDTCTL = WDTPW | WDTHOLD;
+
+	while (0 != (cause = SYSRSTIV)) {
+		if (SYSRSTIV_WDTTO == cause)
+			timeout = True;
+	}
+
+	// Any other content is garbage from a power-up
+	if (SUPERVISOR_MAGIC != supervisor_now.magic) {
+		supervisor_now.magic = SUPERVISOR_MAGIC;
+		supervisor_now.resets = 0;
+		timeout = False;
+	}
+
+	if (timeout) {
+		++supervisor_now.resets;
+		last = supervisor_now;
+	} else {
+		last.magic = 0;
+	}
+
+	supervisor_now.event = SUPERVISOR_IDLE;
+	supervisor_now.timer = Null;
+
+	for (i = 0; i < EVENT_COUNT; i++)
+		supervisor_budget[i] = SUPERVISOR_BUDGET;
+
+	return timeout;
+}
+
+const supervisor_record_t *supervisor_last(void)
+{
+	return (SUPERVISOR_MAGIC == last.magic) ? &last : Null;
+}
+
+void supervisor_set_budget(uint event, uint wdtis)
+{
+	assert(event < EVENT_COUNT);
+	supervisor_budget[event] = wdtis & WDTIS_7;
+}
+
+#endif /* SUPERVISOR_ENABLE */
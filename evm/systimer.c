@@ -3,78 +3,257 @@
 
 #include "include/systimer.h"
 #include "include/event.h"
+#include "include/supervisor.h"
 #include "include/debug.h"
 #include <msp430.h>
 
-volatile u16 sys_tick = 0;
-volatile u16 next_tick = 0;
-
-// We need +1 timer space for the calls to systimer_new inside a timer
-// callback and to also ensure thread safety
-#define TIMER_MAX_COUNT (SYS_TIMER_MAX_COUNT + 1)
 typedef struct timer_instance {
 	u16        counter;
 	tcb_noid_t call;
 	int        id;
+#ifdef SYS_TIMER_PERIODIC
+	u16        period;    // whole ticks per period, 0 if not periodic
+	u16        frac;      // fraction of a tick per period
+	u16        frac_acc;  // accumulated fraction, carried on overflow
+#endif
+#ifdef SYS_TIMER_GROUPS
+	u8         group;     // SYS_GROUP flags and TIMER_SUSPENDED
+#endif
 } timer_instance_t;
 
-static timer_instance_t timer[TIMER_MAX_COUNT] = {{0}};
+// While suspended the counter holds the remaining time, not the deadline
+#define TIMER_SUSPENDED 0x80
+
+/* Everything a domain needs to run on its own: the pool, the tick counters,
+ * the tick event and the hardware timer that generates the tick */
+typedef struct timer_domain {
+	timer_instance_t *timer;
+	int               count;
+	event_id_t        event;
+	u16               scale;     // ticks per SYS_TICK_FRAC_DIV timeout units
+	u16               tick_div;  // 1/SYS_TICK_IN_SEC seconds per tick
+	void            (*start)(void);
+	void            (*stop)(void);
+	volatile u16      sys_tick;
+	volatile u16      next_tick;
+	// This is for thread safety, -1 means unlocked, positive value means the
+	// corresponding timer is locked for update
+	volatile int      timer_lock;
+#ifdef SYS_TIMER_STATS
+	systimer_stats_t  stats;
+#endif
+} timer_domain_t;
 
-// This is for thread safety, -1 means unlocked, positive value means the
-// corresponding timer is locked for update
-static volatile int timer_lock = -1;
+// We need +1 timer space for the calls to systimer_new inside a timer
+// callback and to also ensure thread safety
+static timer_instance_t fast_timer[SYS_TIMER_MAX_COUNT + 1] = {{0}};
+#ifdef SYS_SLOW_DOMAIN
+static timer_instance_t slow_timer[SYS_SLOW_TIMER_MAX_COUNT + 1] = {{0}};
+#endif
 
 // Called when adding a timer fails because all instances are occupied
 static void default_fail_callback (void) {}
 static pfn_t fail_callback = default_fail_callback;
 
-static void systimer_sys_tick(void);
-
+/******************************* HARDWARE ***********************************/
+/* SYS_DOMAIN_FAST runs on TimerA1 */
 #ifdef SYS_TIMER_STOP_MODE
-static inline void timer_start(void)
+static void fast_timer_start(void)
 {
 	TA1CTL |= TACLR | MC_1;
 	TA1CCTL0 |= CCIE;
 }
-static inline void timer_stop(void)
+static void fast_timer_stop(void)
 {
 	TA1CTL &= ~(MC0 | MC1);
 	TA1CCTL0 &= ~(CCIFG | CCIE);
 }
 #else
-static inline void timer_start(void) {}
-static inline void timer_stop(void) {}
+static void fast_timer_start(void) {}
+static void fast_timer_stop(void) {}
 #endif
 
+static void fast_timer_init(void)
+{
+	TA1CTL = TACLR | TASSEL_1;
+	TA1CCTL0 |= CCIE;
+	TA1CCR0 = (32 * SYS_TICK_MS) - 1;
+
+	#ifndef SYS_TIMER_STOP_MODE
+	TA1CTL |= MC_1;
+	TA1CCTL0 |= CCIE;
+	#endif
+}
+
+/* SYS_DOMAIN_SLOW runs on TimerA2 */
+#ifdef SYS_SLOW_DOMAIN
+#ifdef SYS_SLOW_TIMER_STOP_MODE
+static void slow_timer_start(void)
+{
+	TA2CTL |= TACLR | MC_1;
+	TA2CCTL0 |= CCIE;
+}
+static void slow_timer_stop(void)
+{
+	TA2CTL &= ~(MC0 | MC1);
+	TA2CCTL0 &= ~(CCIFG | CCIE);
+}
+#else
+static void slow_timer_start(void) {}
+static void slow_timer_stop(void) {}
+#endif
+
+static void slow_timer_init(void)
+{
+	TA2CTL = TACLR | TASSEL_1;
+	TA2CCTL0 |= CCIE;
+	TA2CCR0 = (u16)(32768UL * SYS_SLOW_TICK_SEC - 1);
+
+	#ifndef SYS_SLOW_TIMER_STOP_MODE
+	TA2CTL |= MC_1;
+	TA2CCTL0 |= CCIE;
+	#endif
+}
+#endif
+/****************************************************************************/
+
+static timer_domain_t domain[SYS_DOMAIN_COUNT] = {
+	{fast_timer, countof(fast_timer), EVENT_SYS_TICK, SYS_TICK_IN_SEC, 1,
+	 fast_timer_start, fast_timer_stop, 0, 0, -1},
+#ifdef SYS_SLOW_DOMAIN
+	{slow_timer, countof(slow_timer), EVENT_SYS_TICK_SLOW, SYS_TICK_FRAC_DIV,
+	 SYS_TICK_IN_SEC, slow_timer_start, slow_timer_stop, 0, 0, -1},
+#endif
+};
+
+#ifdef SYS_TIMER_PERIODIC
+static inline void timer_set_period(timer_instance_t *t, u16 period, u16 frac)
+{
+	t->period = period;
+	t->frac = frac;
+	t->frac_acc = 0;
+}
+
+// Advances the deadline by one period and carries the fraction. Periods that
+// are already missed are skipped, so the timer stays phase-locked.
+static inline u16 periodic_rearm(timer_instance_t *t, u16 counter)
+{
+	do {
+		counter += t->period;
+		t->frac_acc += t->frac;
+		if (t->frac_acc >= SYS_TICK_FRAC_DIV) {
+			t->frac_acc -= SYS_TICK_FRAC_DIV;
+			++counter;
+		}
+	} while ((s16)counter <= 0);
+
+	return counter;
+}
+#else
+static inline void timer_set_period(timer_instance_t *t, u16 period, u16 frac) {}
+#endif
+
+#ifdef SYS_TIMER_GROUPS
+static inline void timer_set_group(timer_instance_t *t, u8 group) { t->group = group; }
+static inline bool timer_is_suspended(timer_instance_t *t)
+{
+	return t->group & TIMER_SUSPENDED;
+}
+#else
+static inline void timer_set_group(timer_instance_t *t, u8 group) {}
+static inline bool timer_is_suspended(timer_instance_t *t) { return False; }
+#endif
+
+#ifdef SYS_TIMER_CHECKPOINT
+/* The counters of the slots that the update has not reached yet still hold
+ * the ticks of this update, a save in the middle would store them too long */
+static bool updating;
+static inline void update_begin(void) { updating = True; }
+static inline void update_end(void) { updating = False; }
+#else
+static inline void update_begin(void) {}
+static inline void update_end(void) {}
+#endif
+
+#ifdef SYS_TIMER_STATS
+static inline void stats_inc(u16 *counter)
+{
+	if (*counter != UINT16_MAX)
+		++*counter;
+}
+
 // Don't use with interrupts enabled
-static inline void update_next_tick(u16 current_tick)
+static inline void stats_alloc(timer_domain_t *d)
+{
+	if (++d->stats.active > d->stats.peak)
+		d->stats.peak = d->stats.active;
+}
+
+static inline void stats_free(timer_domain_t *d, u16 count)
+{
+	_uninterrupted(d->stats.active -= count);
+}
+
+static inline void stats_fail(timer_domain_t *d)
+{
+	stats_inc(&d->stats.alloc_fail);
+}
+
+static inline void stats_late(timer_domain_t *d, u16 latency)
+{
+	uint bin;
+
+	for (bin = 0; latency && bin < SYS_STATS_LATE_BINS - 1; bin++)
+		latency >>= 1;
+	stats_inc(&d->stats.late[bin]);
+}
+
+static inline void stats_tick(timer_domain_t *d, u16 calls)
+{
+	if (calls > d->stats.calls_max)
+		d->stats.calls_max = calls;
+	d->stats.calls += calls;
+	++d->stats.ticks;
+}
+#else
+static inline void stats_alloc(timer_domain_t *d) {}
+static inline void stats_free(timer_domain_t *d, u16 count) {}
+static inline void stats_fail(timer_domain_t *d) {}
+static inline void stats_late(timer_domain_t *d, u16 latency) {}
+static inline void stats_tick(timer_domain_t *d, u16 calls) {}
+#endif
+
+// Don't use with interrupts enabled
+EVM_RAMFUNC static inline void update_next_tick(timer_domain_t *d, u16 current_tick)
 {
 	assert(current_tick != 0);
 
-	if (current_tick < next_tick) {
-		next_tick = current_tick;
-	} else if (next_tick == 0) {
-		next_tick = current_tick;
-		timer_start();
+	if (current_tick < d->next_tick) {
+		d->next_tick = current_tick;
+	} else if (d->next_tick == 0) {
+		d->next_tick = current_tick;
+		d->start();
 	}
 }
 
-static inline void critical_update_next_tick(u16 current_tick)
+static inline void critical_update_next_tick(timer_domain_t *d, u16 current_tick)
 {
-	_uninterrupted(update_next_tick(current_tick));
+	_uninterrupted(update_next_tick(d, current_tick));
 }
 
+EVM_RAMFUNC static void fast_sys_tick(void);
+#ifdef SYS_SLOW_DOMAIN
+static void slow_sys_tick(void);
+#endif
+
 void systimer_init(void)
 {
-	event_register(EVENT_SYS_TICK, systimer_sys_tick);
+	event_register(EVENT_SYS_TICK, fast_sys_tick);
+	fast_timer_init();
 
-	TA1CTL = TACLR | TASSEL_1;
-	TA1CCTL0 |= CCIE;
-	TA1CCR0 = (32 * SYS_TICK_MS) - 1;
-
-	#ifndef SYS_TIMER_STOP_MODE
-	TA1CTL |= MC_1;
-	TA1CCTL0 |= CCIE;
+	#ifdef SYS_SLOW_DOMAIN
+	event_register(EVENT_SYS_TICK_SLOW, slow_sys_tick);
+	slow_timer_init();
 	#endif
 }
 
@@ -83,50 +262,115 @@ void systimer_register_fail_callback(pfn_t callback)
 	fail_callback = callback ? callback : default_fail_callback;
 }
 
-bool _systimer_new(u16 timeout_ms, tcb_noid_t callback, int id)
+// Finds a free timer instance and returns it locked, -1 if there is none
+static int timer_claim(timer_domain_t *d)
 {
 	int i;
 
+	for (i = 0; i < d->count; i++) {
+		d->timer_lock = i;
+		if (0 == d->timer[i].counter)
+			return i;
+	}
+
+	d->timer_lock = -1;
+	return -1;
+}
+
+bool _systimer_new(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id)
+{
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
+	int i;
+
 	// No timeout, no registry
 	if (timeout_ms == 0)
 		return True;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
-		timer_lock = i;
-		if (0 == timer[i].counter) {
-			timer[i].counter = timeout_ms;
-			timer[i].call = callback;
-			timer[i].id = id;
-			timer_lock = -1;
-			critical_update_next_tick(timeout_ms + sys_tick);
-			return True;
-		}
+	i = timer_claim(d);
+	if (i < 0) {
+		// too many timers registered at once, maybe increase max count
+		stats_fail(d);
+		fail_callback();
+		return False;
 	}
 
-	timer_lock = -1;
-	// too many timers registered at once, maybe increase max count
-	fail_callback();
-	return False;
+	t = &d->timer[i];
+	t->counter = timeout_ms;
+	t->call = callback;
+	t->id = id;
+	timer_set_period(t, 0, 0);
+	timer_set_group(t, 0);
+	d->timer_lock = -1;
+	_uninterrupted(
+		stats_alloc(d);
+		update_next_tick(d, timeout_ms + d->sys_tick);
+	);
+	return True;
 }
 
+#ifdef SYS_TIMER_PERIODIC
+bool _systimer_new_periodic(sys_domain_t dom, u16 period_ms, tcb_noid_t callback, int id)
+{
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
+	u32 scaled = (u32)period_ms * d->scale;
+	u16 counter;
+	int i;
+
+	if (period_ms == 0)
+		return True;
+	// the period should fit into a positive s16 tick count
+	assert(scaled / SYS_TICK_FRAC_DIV < 0x8000);
+
+	i = timer_claim(d);
+	if (i < 0) {
+		stats_fail(d);
+		fail_callback();
+		return False;
+	}
+
+	t = &d->timer[i];
+	timer_set_period(t, scaled / SYS_TICK_FRAC_DIV, scaled % SYS_TICK_FRAC_DIV);
+	counter = periodic_rearm(t, 0);
+	t->counter = counter;
+	t->call = callback;
+	t->id = id;
+	timer_set_group(t, 0);
+	d->timer_lock = -1;
+	_uninterrupted(
+		stats_alloc(d);
+		update_next_tick(d, counter + d->sys_tick);
+	);
+	return True;
+}
+#endif
+
 // Assumes interrupts are disabled
-bool _systimer_new_isr(u16 timeout_ms, tcb_noid_t callback, int id)
+bool _systimer_new_isr(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id)
 {
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
 	int i;
 
+	trace_isr_timer(dom, timeout_ms, callback, id);
 	if (timeout_ms == 0)
 		return True;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
-		if (0 == timer[i].counter && i != timer_lock) {
-			timer[i].counter = timeout_ms;
-			timer[i].call = callback;
-			timer[i].id = id;
-			update_next_tick(timeout_ms + sys_tick);
+	for (i = 0, t = d->timer; i < d->count; i++, t++) {
+		if (0 == t->counter && i != d->timer_lock) {
+			t->counter = timeout_ms;
+			t->call = callback;
+			t->id = id;
+			timer_set_period(t, 0, 0);
+			timer_set_group(t, 0);
+			stats_alloc(d);
+			update_next_tick(d, timeout_ms + d->sys_tick);
 			return True;
 		}
 	}
 
+	stats_fail(d);
 	fail_callback();
 	return False;
 }
@@ -137,8 +381,9 @@ bool _systimer_new_isr(u16 timeout_ms, tcb_noid_t callback, int id)
  * about what can be used in an isr and what can not. I also wanted to get rid
  * of the short interrupt disabling sections and make things work a bit faster
  * for the isr version. */
-bool _systimer_new_thread_safe(u16 timeout_ms, tcb_noid_t callback, int id)
+bool _systimer_new_thread_safe(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id)
 {
+	timer_domain_t *d = &domain[dom];
 	int i;
 	int lock_save;
 	uint state_save;
@@ -146,14 +391,14 @@ bool _systimer_new_thread_safe(u16 timeout_ms, tcb_noid_t callback, int id)
 	if (timeout_ms == 0)
 		return True;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
+	for (i = 0; i < d->count; i++) {
 		// A critical section, we are trying to lock the timer for update
 		state_save = __get_interrupt_state();
 		__disable_interrupt();
-		if (0 == timer[i].counter) {
-			lock_save = timer_lock;
+		if (0 == d->timer[i].counter) {
+			lock_save = d->timer_lock;
 			if (i != lock_save) {
-				timer_lock = i;
+				d->timer_lock = i;
 				__set_interrupt_state(state_save);
 			} else {
 				__set_interrupt_state(state_save);
@@ -164,11 +409,11 @@ bool _systimer_new_thread_safe(u16 timeout_ms, tcb_noid_t callback, int id)
 			continue;
 		}
 
-		timer[i].counter = timeout_ms;
-		timer[i].call = callback;
-		timer[i].id = id;
-		timer_lock = lock_save;
-		critical_update_next_tick(timeout_ms + sys_tick);
+		d->timer[i].counter = timeout_ms;
+		d->timer[i].call = callback;
+		d->timer[i].id = id;
+		d->timer_lock = lock_save;
+		critical_update_next_tick(d, timeout_ms + d->sys_tick);
 		return True;
 	}
 
@@ -177,111 +422,413 @@ bool _systimer_new_thread_safe(u16 timeout_ms, tcb_noid_t callback, int id)
 }
 #endif
 
-bool _systimer_renew(u16 timeout_ms, tcb_noid_t callback, int id)
+bool _systimer_renew(sys_domain_t dom, u16 timeout_ms, tcb_noid_t callback, int id)
 {
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
 	int i;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
+	for (i = 0, t = d->timer; i < d->count; i++, t++) {
 		// The timer should be running also, not deprecated
-		if (callback == timer[i].call && id == timer[i].id
-		    && 0 != timer[i].counter) {
+		if (callback == t->call && id == t->id && 0 != t->counter) {
 			// Since systimer_new does not touch a timer with counter != 0,
 			// we are safe here
-			timer[i].counter = timeout_ms;
-			if (timeout_ms)
-				critical_update_next_tick(timeout_ms + sys_tick);
+			t->counter = timeout_ms;
+			if (!timeout_ms)
+				stats_free(d, 1);
+			// a suspended timer takes the timeout as its remaining time
+			else if (!timer_is_suspended(t))
+				critical_update_next_tick(d, timeout_ms + d->sys_tick);
 			return True;
 		}
 	}
 
 	// if not found, register new
 	if (timeout_ms) {
-		return _systimer_new(timeout_ms, callback, id);
+		return _systimer_new(dom, timeout_ms, callback, id);
 	} else {
 		return True;
 	}
 }
 
-bool _systimer_is_running(tcb_noid_t callback, int id)
+bool _systimer_is_running(sys_domain_t dom, tcb_noid_t callback, int id)
 {
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
 	int i;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
-		if (callback == timer[i].call && id == timer[i].id
-		    && 0 != timer[i].counter)
+	for (i = 0, t = d->timer; i < d->count; i++, t++) {
+		if (callback == t->call && id == t->id && 0 != t->counter)
 			return True;
 	}
 	return False;
 }
 
-static inline void systimer_update_tick(u16 tick_count)
+EVM_RAMFUNC static inline void systimer_update_tick(timer_domain_t *d, u16 tick_count)
 {
+	timer_instance_t *t;
 	int i;
 	u16 min_tick;
 	u16 counter;
+	u16 calls = 0;
+	u16 freed = 0;
 
 	min_tick = UINT16_MAX;
 	// to know if a new timer is registered during update
-	next_tick = UINT16_MAX;
+	d->next_tick = UINT16_MAX;
 
-	for (i = 0; i < TIMER_MAX_COUNT; i++) {
-		counter = timer[i].counter;
-		if (0 != counter) {
+	for (i = 0, t = d->timer; i < d->count; i++, t++) {
+		counter = t->counter;
+		if (0 != counter && !timer_is_suspended(t)) {
 			counter -= tick_count;
 			if ((s16)counter <= 0) {
-				if (-1 == timer[i].id) {
-					timer[i].call();
+				stats_late(d, -counter);
+				++calls;
+				supervisor_timer((pfn_t)t->call);
+				if (-1 == t->id) {
+					t->call();
+					supervisor_timer_done();
 					counter = 0;
-				} else {
+					++freed;
+				}
+				#ifdef SYS_TIMER_PERIODIC
+				else if (t->period) {
+					tcb_noid_t call = t->call;
+					int id = t->id;
+					u16 period = t->period;
+					u16 before = t->counter;
+
+					((tcb_periodic_t)call)(id);
+					supervisor_timer_done();
+					/* The callback may have deleted or renewed itself, and
+					 * a new timer may have taken the freed slot since. Only
+					 * the same untouched timer is re-armed, anything else
+					 * has already set its own counter and next tick. */
+					if (call != t->call || id != t->id
+					    || period != t->period || before != t->counter)
+						continue;
+					counter = periodic_rearm(t, counter);
+				}
+				#endif
+				else {
 					u16 latency = -counter;
-					counter = ((tcb_id_t)(timer[i].call))(timer[i].id, latency);
+					counter = ((tcb_id_t)(t->call))(t->id, latency);
+					supervisor_timer_done();
+					if (!counter)
+						++freed;
 				}
 			}
 
 			if (counter && counter < min_tick)
 				min_tick = counter;
 
-			timer[i].counter = counter;
+			t->counter = counter;
 		}
 	}
 
+	if (freed)
+		stats_free(d, freed);
+	stats_tick(d, calls);
+
 	if (min_tick == UINT16_MAX) {
 		_uninterrupted(
-			if (next_tick == UINT16_MAX) {
-				next_tick = 0;
-				sys_tick = 0;
-				timer_stop();
+			if (d->next_tick == UINT16_MAX) {
+				d->next_tick = 0;
+				d->sys_tick = 0;
+				d->stop();
 			}
 		);
 	} else {
-		critical_update_next_tick(min_tick);
+		critical_update_next_tick(d, min_tick);
 	}
 }
 
-static void systimer_sys_tick(void)
+EVM_RAMFUNC static inline void systimer_sys_tick(timer_domain_t *d)
 {
-	u16 tick = sys_tick;
+	u16 tick = d->sys_tick;
 
-	sys_tick -= tick;
-	systimer_update_tick(tick);
+	d->sys_tick -= tick;
+	update_begin();
+	systimer_update_tick(d, tick);
+	update_end();
 	// the below part is to clear tick events, occurred during update
-	event_clear(EVENT_SYS_TICK);
-	tick = next_tick;
-	if (tick && sys_tick >= tick)
-		event_set(EVENT_SYS_TICK);
+	event_clear(d->event);
+	tick = d->next_tick;
+	if (tick && d->sys_tick >= tick)
+		event_set(d->event);
+}
+
+#ifdef SYS_TIMER_GROUPS
+bool _systimer_group_tag(sys_domain_t dom, tcb_noid_t callback, int id, u8 groups)
+{
+	timer_domain_t *d = &domain[dom];
+	timer_instance_t *t;
+	int i;
+
+	for (i = 0, t = d->timer; i < d->count; i++, t++) {
+		if (callback == t->call && id == t->id && 0 != t->counter) {
+			t->group = (t->group & TIMER_SUSPENDED) | (groups & SYS_GROUP_ALL);
+			return True;
+		}
+	}
+	return False;
+}
+
+// Don't use the group passes below with interrupts enabled
+static void group_suspend(u8 groups)
+{
+	timer_domain_t *d;
+	timer_instance_t *t;
+	int i;
+	u16 remaining;
+
+	for (d = domain; d < domain + SYS_DOMAIN_COUNT; d++) {
+		for (i = 0, t = d->timer; i < d->count; i++, t++) {
+			if (0 != t->counter && (t->group & groups)
+			    && !(t->group & TIMER_SUSPENDED)) {
+				// the ticks that are not yet applied by the update
+				remaining = t->counter - d->sys_tick;
+				t->counter = (s16)remaining > 0 ? remaining : 1;
+				t->group |= TIMER_SUSPENDED;
+			}
+		}
+	}
+}
+
+static void group_resume(u8 groups)
+{
+	timer_domain_t *d;
+	timer_instance_t *t;
+	int i;
+
+	for (d = domain; d < domain + SYS_DOMAIN_COUNT; d++) {
+		for (i = 0, t = d->timer; i < d->count; i++, t++) {
+			if (0 != t->counter && (t->group & groups)
+			    && (t->group & TIMER_SUSPENDED)) {
+				t->group &= ~TIMER_SUSPENDED;
+				t->counter += d->sys_tick;
+				update_next_tick(d, t->counter);
+			}
+		}
+	}
+}
+
+static void group_cancel(u8 groups)
+{
+	timer_domain_t *d;
+	timer_instance_t *t;
+	int i;
+	u16 freed;
+
+	for (d = domain; d < domain + SYS_DOMAIN_COUNT; d++) {
+		freed = 0;
+		for (i = 0, t = d->timer; i < d->count; i++, t++) {
+			if (0 != t->counter && (t->group & groups)) {
+				t->counter = 0;
+				t->group = 0;
+				++freed;
+			}
+		}
+		if (freed)
+			stats_free(d, freed);
+	}
+}
+
+void systimer_group_suspend(u8 groups)
+{
+	groups &= SYS_GROUP_ALL;
+	_uninterrupted(group_suspend(groups));
+}
+
+void systimer_group_resume(u8 groups)
+{
+	groups &= SYS_GROUP_ALL;
+	_uninterrupted(group_resume(groups));
+}
+
+void systimer_group_cancel(u8 groups)
+{
+	groups &= SYS_GROUP_ALL;
+	_uninterrupted(group_cancel(groups));
+}
+#endif
+
+#ifdef SYS_TIMER_CHECKPOINT
+int _systimer_save(systimer_record_t *records, uint max, u32 *earliest)
+{
+	timer_domain_t *d;
+	timer_instance_t *t;
+	systimer_record_t *rec = records;
+	int i;
+	u16 remaining;
+	u32 deadline;
+
+	*earliest = 0;
+	// Not from a timer callback, see lpm5_sleep
+	assert(!updating);
+	if (updating)
+		return -1;
+
+	for (d = domain; d < domain + SYS_DOMAIN_COUNT; d++) {
+		for (i = 0, t = d->timer; i < d->count; i++, t++) {
+			if (0 == t->counter)
+				continue;
+			if (rec == records + max)
+				return -1;
+
+			rec->call = t->call;
+			rec->id = t->id;
+			rec->domain = d - domain;
+			#ifdef SYS_TIMER_PERIODIC
+			rec->period = t->period;
+			rec->frac = t->frac;
+			rec->frac_acc = t->frac_acc;
+			#else
+			rec->period = 0;
+			#endif
+			#ifdef SYS_TIMER_GROUPS
+			rec->group = t->group;
+			#else
+			rec->group = 0;
+			#endif
+
+			if (timer_is_suspended(t)) {
+				rec->remaining = t->counter;
+			} else {
+				remaining = t->counter - d->sys_tick;
+				rec->remaining = (s16)remaining > 0 ? remaining : 1;
+				deadline = (u32)rec->remaining * d->tick_div;
+				if (!*earliest || deadline < *earliest)
+					*earliest = deadline;
+			}
+			++rec;
+		}
+	}
+	return rec - records;
+}
+
+void _systimer_restore(const systimer_record_t *records, uint count, u32 elapsed)
+{
+	const systimer_record_t *rec;
+	timer_domain_t *d;
+	timer_instance_t *t;
+	u32 passed;
+	int i;
+
+	for (rec = records; rec < records + count; rec++) {
+		if (rec->domain >= SYS_DOMAIN_COUNT)
+			continue;
+		d = &domain[rec->domain];
+
+		i = timer_claim(d);
+		if (i < 0) {
+			stats_fail(d);
+			fail_callback();
+			continue;
+		}
+
+		t = &d->timer[i];
+		t->call = rec->call;
+		t->id = rec->id;
+		timer_set_period(t, rec->period, rec->frac);
+		#ifdef SYS_TIMER_PERIODIC
+		t->frac_acc = rec->frac_acc;
+		#endif
+		timer_set_group(t, rec->group);
+
+		if (timer_is_suspended(t)) {
+			t->counter = rec->remaining;
+			d->timer_lock = -1;
+			_uninterrupted(stats_alloc(d));
+			continue;
+		}
+
+		passed = elapsed / d->tick_div;
+		t->counter = passed < rec->remaining ? rec->remaining - passed : 1;
+		d->timer_lock = -1;
+		_uninterrupted(
+			stats_alloc(d);
+			update_next_tick(d, t->counter + d->sys_tick);
+		);
+	}
+}
+#endif
+
+#ifdef SYS_TIMER_STATS
+void systimer_stats_get(sys_domain_t dom, systimer_stats_t *stats)
+{
+	_uninterrupted(*stats = domain[dom].stats);
+}
+
+void systimer_stats_reset(sys_domain_t dom)
+{
+	systimer_stats_t *stats = &domain[dom].stats;
+	uint i;
+
+	_uninterrupted(
+		stats->peak = stats->active;
+		stats->alloc_fail = 0;
+		for (i = 0; i < SYS_STATS_LATE_BINS; i++)
+			stats->late[i] = 0;
+		stats->calls_max = 0;
+		stats->calls = 0;
+		stats->ticks = 0;
+	);
+}
+
+uint systimer_stats_owners(sys_domain_t dom, tcb_noid_t *calls, uint max)
+{
+	timer_domain_t *d = &domain[dom];
+	uint n = 0;
+	int i;
+
+	for (i = 0; i < d->count && n < max; i++) {
+		if (0 != d->timer[i].counter)
+			calls[n++] = d->timer[i].call;
+	}
+	return n;
+}
+#endif
+
+EVM_RAMFUNC static void fast_sys_tick(void)
+{
+	systimer_sys_tick(&domain[SYS_DOMAIN_FAST]);
 }
 
 #pragma vector = TIMER1_A0_VECTOR
-__interrupt void TIMER1_A0_ISR(void)
+EVM_RAMFUNC __interrupt void TIMER1_A0_ISR(void)
 {
+	timer_domain_t *d = &domain[SYS_DOMAIN_FAST];
+
 	#ifndef SYS_TIMER_STOP_MODE
-	if (next_tick == 0)
+	if (d->next_tick == 0)
 		return;
 	#endif
 
-	sys_tick += SYS_TICK_MS;
-	if (sys_tick >= next_tick)
-		event_set_isr(EVENT_SYS_TICK);
+	d->sys_tick += SYS_TICK_MS;
+	// The ticks are not traced, the replay generates its own
+	if (d->sys_tick >= d->next_tick)
+		_event_set_isr(EVENT_SYS_TICK);
+}
+
+#ifdef SYS_SLOW_DOMAIN
+static void slow_sys_tick(void)
+{
+	systimer_sys_tick(&domain[SYS_DOMAIN_SLOW]);
 }
 
+#pragma vector = TIMER2_A0_VECTOR
+__interrupt void TIMER2_A0_ISR(void)
+{
+	timer_domain_t *d = &domain[SYS_DOMAIN_SLOW];
+
+	#ifndef SYS_SLOW_TIMER_STOP_MODE
+	if (d->next_tick == 0)
+		return;
+	#endif
 
+	d->sys_tick += SYS_SLOW_TICK_SEC;
+	if (d->sys_tick >= d->next_tick)
+		_event_set_isr(EVENT_SYS_TICK_SLOW);
+}
+#endif
@@ -0,0 +1,40 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/topic.h"
+#include "include/systimer.h"
+#include "include/debug.h"
+#include <string.h>
+
+void topic_subscribe(topic_t *topic, event_id_t id)
+{
+	assert(id < EVENT_COUNT);
+	_uninterrupted(topic->subscribers |= (event_reg_t)1 << id);
+}
+
+void topic_unsubscribe(topic_t *topic, event_id_t id)
+{
+	_uninterrupted(topic->subscribers &= ~((event_reg_t)1 << id));
+}
+
+void topic_publish_payload(topic_t *topic, const void *payload)
+{
+	u8 next = topic->latest ^ 1;
+
+	memcpy(topic->buf + (next ? topic->size : 0), payload, topic->size);
+	topic->latest = next;
+	++topic->seq;
+	topic_publish(topic);
+}
+
+u16 topic_read(const topic_t *topic, void *payload)
+{
+	u16 seq;
+
+	// Copy again if a publish switched the snapshots meanwhile
+	do {
+		seq = topic->seq;
+		memcpy(payload, topic_payload(topic), topic->size);
+	} while (seq != topic->seq);
+	return seq;
+}
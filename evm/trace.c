@@ -0,0 +1,145 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/trace.h"
+#include "include/uart.h"
+#include "include/ring.h"
+#include "include/systimer.h"
+#include <msp430.h>
+
+#ifdef TRACE_ENABLE
+
+#ifdef UART_RX_FRAME_MODE
+#error "trace timestamps with TA0, which is used by UART_RX_FRAME_MODE"
+#endif
+
+RING_DEFINE(trace_ring, TRACE_BUFFER_SIZE);
+
+static u16 epoch;      // upper half of the timestamp, counted by the overflows
+static u32 last;       // timestamp of the previous record
+static u16 dropped;
+
+/******************************* HARDWARE ***********************************/
+static inline void timestamp_start(void)
+{
+	TA0CTL = TASSEL_1 | MC_2 | TACLR | TAIE;
+}
+
+// Called with the interrupts disabled
+static u32 timestamp(void)
+{
+	u16 high = epoch;
+	u16 low;
+
+	// TA0 runs asynchronous to MCLK, read until two reads agree
+	do {
+		low = TA0R;
+	} while (low != TA0R);
+
+	// The overflow happened but its ISR has not run yet
+	if ((TA0CTL & TAIFG) && low < 0x8000)
+		++high;
+	return ((u32)high << 16) | low;
+}
+
+#pragma vector = TIMER0_A1_VECTOR
+__interrupt void TIMER0_A1_ISR(void)
+{
+	if (TA0IV == TA0IV_TAIFG)
+		++epoch;
+}
+/****************************************************************************/
+
+// Writes the record with its delta and any gap before it, or counts a drop
+static void record(u16 type, const u16 *data, u16 size)
+{
+	u32 now = timestamp();
+	u32 delta = now - last;
+	u16 head[2];
+	u16 gap[2] = {(u16)(delta >> 16), TRACE_GAP};
+	u16 need = sizeof(head) + size;
+
+	if (gap[0])
+		need += sizeof(gap);
+	if (dropped)
+		need += sizeof(head);
+
+	if (ring_space(&trace_ring) < need) {
+		if (dropped < 0x0FFF)
+			++dropped;
+		return;
+	}
+
+	if (gap[0])
+		ring_write(&trace_ring, gap, sizeof(gap));
+	if (dropped) {
+		head[0] = 0;
+		head[1] = TRACE_DROP | dropped;
+		ring_write(&trace_ring, head, sizeof(head));
+		dropped = 0;
+	}
+	head[0] = (u16)delta;
+	head[1] = type;
+	ring_write(&trace_ring, head, sizeof(head));
+	if (size)
+		ring_write(&trace_ring, data, size);
+	last = now;
+}
+
+void _trace_event(uint id)
+{
+	record(TRACE_EVENT | (id & 0x0FFF), Null, 0);
+}
+
+void trace_event(uint id)
+{
+	_uninterrupted(_trace_event(id));
+}
+
+void _trace_events(uint mask)
+{
+	uint id;
+
+	for (id = 0; mask; id++, mask >>= 1) {
+		if (mask & 1)
+			_trace_event(id);
+	}
+}
+
+void trace_events(uint mask)
+{
+	_uninterrupted(_trace_events(mask));
+}
+
+void _trace_timer(uint domain, u16 timeout, pfn_t callback, int id)
+{
+	u16 data[3];
+
+	data[0] = timeout;
+	data[1] = (u16)(uintptr_t)callback;
+	data[2] = (u16)id;
+	record(TRACE_TIMER | (domain & 0x0FFF), data, sizeof(data));
+}
+
+void trace_init(void)
+{
+	_uninterrupted(
+		ring_clear(&trace_ring);
+		epoch = 0;
+		last = 0;
+		dropped = 0;
+		timestamp_start();
+	);
+}
+
+u16 trace_read(void *data, u16 length)
+{
+	return ring_read(&trace_ring, data, length);
+}
+
+u16 trace_count(void)
+{
+	return ring_count(&trace_ring);
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,516 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "include/uart.h"
+#include "include/event.h"
+#include "include/systimer.h"
+#include "include/dma.h"
+#include "include/ring.h"
+#include "include/debug.h"
+#include <msp430.h>
+
+#define val_UCBRX(clock, baud) (clock/baud/16)
+#define val_UCBRFX(clock, baud) ((uint)(((double)clock/baud/16 - clock/baud/16) * 16 + 0.5))
+
+/* ACLK ticks of the frame gap, rounded up. The gap timer is restarted at a
+ * random phase of ACLK, one more tick makes sure it is never shorter. */
+#define FRAME_GAP_TICKS \
+	((UART_FRAME_GAP_BITS * 32768UL + UART_BAUD_RATE - 1) / UART_BAUD_RATE + 1)
+
+RING_DEFINE(rx_ring, UART_RX_BUFFER_SIZE);
+RING_DEFINE(tx_ring, UART_TX_BUFFER_SIZE);
+
+#ifdef UART_RX_FRAME_MODE
+typedef char frame_queue_size_check[(UART_FRAME_QUEUE & (UART_FRAME_QUEUE - 1)) ? -1 : 1];
+
+// Lengths of the complete frames in the rx ring, oldest at frame_tail
+static volatile u16 frame_length[UART_FRAME_QUEUE];
+static volatile u8 frame_head;
+static volatile u8 frame_tail;
+// Chars of the frame being received, only used by the ISRs
+static u16 frame_received;
+#else
+// Size of the block the DMA is filling, 0 when the rx ring is full
+static volatile u16 rx_dma_length;
+// Incremented on every block end, to detect progress while polling
+static volatile u16 rx_blocks;
+#endif
+static u16 rx_overrun;
+
+typedef char tx_queue_size_check[(UART_TX_QUEUE & (UART_TX_QUEUE - 1)) ? -1 : 1];
+
+typedef enum tx_sources {
+	TX_FROM_SEND = 0,
+	TX_FROM_REQUEST,
+	TX_FROM_RING
+} tx_source_t;
+
+// Size of the segment the DMA is sending, 0 when the transmitter is idle
+static volatile u16 tx_dma_length;
+static volatile tx_source_t tx_source;
+// A uart_send buffer waiting for the transmitter
+static const u8 *volatile tx_send_data;
+static u16 tx_send_length;
+// Submitted requests, the one at tx_request_tail is being sent
+static uart_tx_request_t *tx_request[UART_TX_QUEUE];
+static volatile u8 tx_request_head;
+static volatile u8 tx_request_tail;
+// Segment of the request at tx_request_tail that is next/being sent
+static u8 tx_iov_index;
+
+/******************************* HARDWARE ***********************************/
+static inline void dma_set_address(volatile void *reg, const volatile void *address)
+{
+	__data16_write_addr((unsigned short)(uintptr_t)reg, (unsigned long)(uintptr_t)address);
+}
+
+#ifdef UART_RX_FRAME_MODE
+/* TA0 in up mode from ACLK, CCR0 fires when the line has been idle for the
+ * gap. Restarting it is the only per char work besides storing the char. */
+static inline void gap_timer_init(void)
+{
+	TA0CTL = TASSEL_1 | TACLR;
+	TA0CCR0 = FRAME_GAP_TICKS - 1;
+	TA0CCTL0 = CCIE;
+}
+
+static inline void gap_timer_restart(void)
+{
+	TA0CTL = TASSEL_1 | MC_1 | TACLR;
+}
+
+static inline void gap_timer_stop(void)
+{
+	TA0CTL = TASSEL_1;
+}
+#else
+static inline void rx_dma_start(u8 *data, u16 length)
+{
+	dma_set_address(&DMA0DA, data);
+	DMA0SZ = length;
+	DMA0CTL = DMADT_0 | DMADSTINCR_3 | DMASRCINCR_0 | DMADSTBYTE | DMASRCBYTE
+	          | DMAIE | DMAEN;
+	// The trigger is edge sensitive, regenerate the edge of a waiting char
+	if (UCA2IFG & UCRXIFG) {
+		UCA2IFG &= ~UCRXIFG;
+		UCA2IFG |= UCRXIFG;
+	}
+}
+
+static inline u16 rx_dma_remaining(void)
+{
+	return DMA0SZ;
+}
+
+static inline void rx_dma_stop(void)
+{
+	DMA0CTL &= ~(DMAEN | DMAIE);
+}
+
+static inline void rx_idle_detect_start(void)
+{
+	UCA2IFG &= ~UCSTTIFG;
+	UCA2IE |= UCSTTIE;
+}
+#endif
+
+static inline void tx_dma_start(const void *data, u16 length)
+{
+	dma_set_address(&DMA1SA, data);
+	DMA1SZ = length;
+	DMA1CTL = DMADT_0 | DMADSTINCR_0 | DMASRCINCR_3 | DMADSTBYTE | DMASRCBYTE
+	          | DMAIE | DMAEN;
+	// Toggling the flag gives the trigger edge for the first char
+	UCA2IFG &= ~UCTXIFG;
+	UCA2IFG |= UCTXIFG;
+}
+/****************************************************************************/
+
+#ifndef UART_RX_FRAME_MODE
+// Don't use with interrupts enabled
+static void rx_next(void)
+{
+	u8 *data;
+	u16 length = ring_peek_write(&rx_ring, &data);
+
+	if (length > UART_RX_BLOCK_SIZE)
+		length = UART_RX_BLOCK_SIZE;
+	rx_dma_length = length;
+	if (length)
+		rx_dma_start(data, length);
+	else
+		++rx_overrun;
+}
+
+// Don't use with interrupts enabled
+static void rx_end_block(u16 received)
+{
+	ring_commit_write(&rx_ring, received);
+	++rx_blocks;
+	rx_next();
+	event_set_traced(EVENT_UART_RX);
+}
+#endif
+
+// Don't use with interrupts enabled
+static void tx_request_complete(void)
+{
+	uart_tx_request_t *request = tx_request[tx_request_tail & (UART_TX_QUEUE - 1)];
+
+	++tx_request_tail;
+	tx_iov_index = 0;
+	request->busy = False;
+	event_set_traced(request->event);
+}
+
+/* Returns the next segment to send from the requests, completes the requests
+ * that have nothing left. Don't use with interrupts enabled */
+static const uart_iov_t *tx_request_segment(void)
+{
+	const uart_tx_request_t *request;
+	const uart_iov_t *iov;
+
+	while (tx_request_tail != tx_request_head) {
+		request = tx_request[tx_request_tail & (UART_TX_QUEUE - 1)];
+		while (tx_iov_index < request->count) {
+			iov = &request->iov[tx_iov_index];
+			if (iov->length)
+				return iov;
+			++tx_iov_index;
+		}
+		tx_request_complete();
+	}
+	return Null;
+}
+
+// Don't use with interrupts enabled
+static void tx_next(void)
+{
+	const uart_iov_t *iov;
+	const u8 *data;
+	u16 length;
+
+	if (tx_dma_length)
+		return;
+
+	if (Null != tx_send_data) {
+		data = tx_send_data;
+		length = tx_send_length;
+		tx_send_data = Null;
+		tx_source = TX_FROM_SEND;
+	} else if (Null != (iov = tx_request_segment())) {
+		data = iov->data;
+		length = iov->length;
+		tx_source = TX_FROM_REQUEST;
+	} else {
+		length = ring_peek_read(&tx_ring, &data);
+		if (0 == length)
+			return;
+		tx_source = TX_FROM_RING;
+	}
+
+	tx_dma_length = length;
+	tx_dma_start(data, length);
+}
+
+#ifndef UART_RX_FRAME_MODE
+static void rx_dma_handler(void)
+{
+	rx_end_block(rx_dma_length);
+}
+#endif
+
+static void tx_dma_handler(void)
+{
+	switch (tx_source) {
+		case TX_FROM_SEND:
+			event_set_traced(EVENT_UART_TX_END);
+			break;
+		case TX_FROM_REQUEST:
+			++tx_iov_index;
+			break;
+		case TX_FROM_RING:
+			ring_commit_read(&tx_ring, tx_dma_length);
+			break;
+	}
+
+	tx_dma_length = 0;
+	tx_next();
+	if (0 == tx_dma_length)
+		event_set_traced(EVENT_UART_TX_END);
+}
+
+#ifndef UART_RX_FRAME_MODE
+/* Runs while there is traffic, flushes the partial block when there was no
+ * progress since the last poll. The cpu wakes once per UART_RX_IDLE_MS instead
+ * of once per char. */
+static u16 rx_idle_poll(int id, u16 latency)
+{
+	static u16 last_remaining;
+	static u16 last_blocks;
+	u16 remaining = rx_dma_remaining();
+	bool idle = (remaining == last_remaining && rx_blocks == last_blocks);
+
+	last_remaining = remaining;
+	last_blocks = rx_blocks;
+	if (!idle)
+		return UART_RX_IDLE_MS;
+
+	_uninterrupted(
+		if (rx_dma_length) {
+			// Stopped first, a char can't be transferred after the count
+			rx_dma_stop();
+			remaining = rx_dma_remaining();
+			if (remaining < rx_dma_length)
+				rx_end_block(rx_dma_length - remaining);
+			else
+				rx_next();
+		}
+		rx_idle_detect_start();
+	);
+	last_remaining = 0;
+	return 0;
+}
+#endif
+
+void uart_set_clock(u32 hz)
+{
+	// Rounded 16 * UCBRF, the same as val_UCBRFX without the floats
+	u16 brw = hz / UART_BAUD_RATE / 16;
+	u32 brf = (hz * 2 / UART_BAUD_RATE + 1) / 2 - (u32)brw * 16;
+	u16 ie = UCA2IE;
+
+	if (brf > 15)
+		brf = 15;
+
+	// The dividers can only be changed in reset, which also clears the IE
+	UCA2CTLW0 |= UCSWRST;
+	UCA2BRW = brw;
+	UCA2MCTLW = (u16)brf << 4 | UCOS16;
+	UCA2CTLW0 &= ~UCSWRST;
+	UCA2IE = ie;
+}
+
+void uart_init(void)
+{
+	UCA2CTLW0 |= UCSWRST;
+
+	UCA2BRW = val_UCBRX(UART_CLOCK_HZ, UART_BAUD_RATE);
+	UCA2MCTLW = val_UCBRFX(UART_CLOCK_HZ, UART_BAUD_RATE) << 4 | UCOS16;
+	// clock sourse SMCLK, no parity, 8 bits, 1 stop bit
+	UCA2CTLW0 = UCSSEL__SMCLK | UCSWRST;
+	UCA2STATW = 0;
+
+	ring_clear(&rx_ring);
+	tx_dma_length = 0;
+	tx_send_data = Null;
+	tx_request_tail = tx_request_head;
+	tx_iov_index = 0;
+
+	// The uart side of the transfers never changes, only the memory side
+	// is set per block
+	dma_register(1, tx_dma_handler);
+	dma_set_address(&DMA1DA, &UCA2TXBUF);
+#ifdef UART_RX_FRAME_MODE
+	frame_tail = frame_head;
+	frame_received = 0;
+	gap_timer_init();
+	DMACTL0 = (UART_DMA_TX_TRIGGER << 8);
+#else
+	dma_register(0, rx_dma_handler);
+	dma_set_address(&DMA0SA, &UCA2RXBUF);
+	DMACTL0 = (UART_DMA_TX_TRIGGER << 8) | UART_DMA_RX_TRIGGER;
+#endif
+
+	UCA2CTLW0 &= ~UCSWRST;
+	UCA2IFG &= ~(UCTXIFG | UCRXIFG);
+#ifdef UART_RX_FRAME_MODE
+	UCA2IE |= UCRXIE;
+#else
+	_uninterrupted(
+		rx_next();
+		rx_idle_detect_start();
+	);
+#endif
+}
+
+#ifdef UART_RX_FRAME_MODE
+u16 uart_frame_length(void)
+{
+	if (frame_tail == frame_head)
+		return 0;
+	return frame_length[frame_tail & (UART_FRAME_QUEUE - 1)];
+}
+
+u16 uart_frame_read(void *data, u16 size)
+{
+	u16 length;
+
+	// The ISR may still append to the newest frame while the queue is full
+	_uninterrupted(
+		length = uart_frame_length();
+		if (length)
+			++frame_tail;
+	);
+	if (0 == length)
+		return 0;
+
+	if (size > length)
+		size = length;
+	ring_read(&rx_ring, data, size);
+	// The part that doesn't fit is dropped
+	ring_commit_read(&rx_ring, length - size);
+	return size;
+}
+
+u16 uart_frame_count(void)
+{
+	return (u8)(frame_head - frame_tail);
+}
+#else
+// Restarts the receiver if it had stopped because the ring was full
+static inline void rx_resume(void)
+{
+	if (0 == rx_dma_length)
+		_uninterrupted(if (0 == rx_dma_length) rx_next());
+}
+
+u16 uart_read(void *data, u16 length)
+{
+	length = ring_read(&rx_ring, data, length);
+	rx_resume();
+	return length;
+}
+
+u16 uart_rx_peek(const u8 **data)
+{
+	return ring_peek_read(&rx_ring, data);
+}
+
+void uart_rx_commit(u16 length)
+{
+	ring_commit_read(&rx_ring, length);
+	rx_resume();
+}
+
+#endif
+
+u16 uart_rx_count(void)
+{
+	return ring_count(&rx_ring);
+}
+
+u16 uart_rx_overruns(void)
+{
+	return rx_overrun;
+}
+
+u16 uart_write(const void *data, u16 length)
+{
+	length = ring_write(&tx_ring, data, length);
+	_uninterrupted(tx_next());
+	return length;
+}
+
+bool uart_send(const void *data, u16 length)
+{
+	bool accepted = False;
+
+	if (0 == length)
+		return True;
+
+	_uninterrupted(
+		// Only one uart_send buffer can be in flight
+		if (Null == tx_send_data
+		    && (0 == tx_dma_length || TX_FROM_SEND != tx_source)) {
+			tx_send_length = length;
+			tx_send_data = data;
+			tx_next();
+			accepted = True;
+		}
+	);
+	return accepted;
+}
+
+bool uart_tx_busy(void)
+{
+	return tx_dma_length != 0;
+}
+
+bool uart_submit(uart_tx_request_t *request)
+{
+	bool accepted = False;
+
+	_uninterrupted(
+		if ((u8)(tx_request_head - tx_request_tail) < UART_TX_QUEUE) {
+			request->busy = True;
+			tx_request[tx_request_head & (UART_TX_QUEUE - 1)] = request;
+			++tx_request_head;
+			tx_next();
+			accepted = True;
+		}
+	);
+	return accepted;
+}
+
+uint uart_tx_slots(void)
+{
+	return UART_TX_QUEUE - (u8)(tx_request_head - tx_request_tail);
+}
+
+u16 uart_tx_space(void)
+{
+	return ring_space(&tx_ring);
+}
+
+#pragma vector = USCI_A2_VECTOR
+__interrupt void USCI_A2_ISR(void)
+{
+	switch (__even_in_range(UCA2IV, 8)) {
+		case 0: break;
+		case 2:
+#ifdef UART_RX_FRAME_MODE
+			if (ring_put(&rx_ring, UCA2RXBUF))
+				++frame_received;
+			else
+				++rx_overrun;
+			gap_timer_restart();
+#endif
+			break;
+		case 4: break;
+		case 6:
+#ifndef UART_RX_FRAME_MODE
+			// A start bit, the first char after an idle period. From now on
+			// the idle poll watches the line until it is idle again.
+			UCA2IE &= ~UCSTTIE;
+			systimer_new_task_isr(UART_RX_IDLE_MS, rx_idle_poll, 0);
+#endif
+			break;
+		case 8: break;
+		default:
+			_never_executed( );
+	}
+}
+
+#ifdef UART_RX_FRAME_MODE
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+{
+	u8 head = frame_head;
+
+	gap_timer_stop();
+	if (0 == frame_received)
+		return;
+
+	if ((u8)(head - frame_tail) < UART_FRAME_QUEUE) {
+		frame_length[head & (UART_FRAME_QUEUE - 1)] = frame_received;
+		frame_head = head + 1;
+	} else {
+		// No room for the boundary, the frame is joined to the newest one
+		frame_length[(head - 1) & (UART_FRAME_QUEUE - 1)] += frame_received;
+		++rx_overrun;
+	}
+	frame_received = 0;
+	event_set_isr(EVENT_UART_RX);
+}
+#endif
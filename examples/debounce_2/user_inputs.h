@@ -0,0 +1,16 @@
+#ifndef USER_INPUTS_H
+#define USER_INPUTS_H
+
+void on_input_0_change(uint state);
+void on_input_0_longpress(uint state);
+void on_input_1_change(uint state);
+
+/* X(ctx, id, port, pin, pull, debounce_ms, longpress_ms, on_change, on_longpress) */
+#define MSPIO_INPUTS(X, ctx) \
+	X(ctx, INPUT_0, 2, BIT4, MSPIO_FLOATING, 100, 3000, on_input_0_change, on_input_0_longpress) \
+	X(ctx, INPUT_1, 2, BIT5, MSPIO_FLOATING, 100, 0,    on_input_1_change, Null)
+
+#define MSPIO_PORTS(X) \
+	X(2)
+
+#endif
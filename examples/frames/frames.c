@@ -0,0 +1,95 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include <msp430.h>
+#include "evm/include/event.h"
+#include "evm/include/systimer.h"
+#include "evm/include/uart.h"
+#include "evm/include/cobs.h"
+#include "port_map.h"
+
+#define FRAME_SIZE    64
+
+static u8 frame[FRAME_SIZE];
+static u8 reply[COBS_ENCODED_SIZE(FRAME_SIZE)];
+static cobs_decoder_t decoder;
+/* The reply is sent from its own buffer, a full frame never has to fit the tx
+ * ring. EVENT_UART_TX_END is set when it is sent */
+static uart_iov_t reply_iov = {reply, 0};
+static uart_tx_request_t reply_request = {&reply_iov, 1, EVENT_UART_TX_END, False};
+
+void receiver(void)
+{
+	cobs_receive(&decoder);
+}
+
+/* Called once per valid frame, the payload is echoed back in a new frame */
+void on_frame(void)
+{
+	u16 length = cobs_frame_length(&decoder);
+
+	/* Leave the frame in the decoder until the previous reply is sent, the
+	 * reception stops meanwhile and the data waits in the rx ring */
+	if (reply_request.busy)
+		return;
+
+	reply_iov.length = cobs_encode(reply, sizeof(reply), frame, length);
+	if (!uart_submit(&reply_request))
+		return;
+
+	cobs_release(&decoder);
+	// Continue with the data that arrived after this frame
+	cobs_receive(&decoder);
+}
+
+void on_tx_end(void)
+{
+	// Retry a frame that was waiting for the reply buffer
+	if (decoder.ready)
+		on_frame();
+}
+
+void init_clocks(void)
+{
+	uint timeout = 1000;
+
+	UCSCTL6 &= ~(XT1OFF);
+
+	do
+	{
+		UCSCTL7 &= ~(XT2OFFG | XT1LFOFFG | DCOFFG);
+		SFRIFG1 &= ~OFIFG;
+	} while ((SFRIFG1 & OFIFG) && --timeout);
+
+	PMMCTL0 = PMMPW | PMMCOREV_3;
+
+	// For clock 20971520 D*(N+1)*Aclk, D = 32, N = 19, set UART_CLOCK_HZ to it
+	UCSCTL1 = DCORSEL2 | DCORSEL1;
+	UCSCTL2 = 19 | FLLD0 | FLLD2;
+	UCSCTL4 = SELA__XT1CLK | SELS__DCOCLK | SELM__DCOCLK;
+
+	return;
+}
+
+void frames_init(void)
+{
+	PORT_UART(SEL) |= PIN_UART_TX | PIN_UART_RX;
+
+	uart_init();
+	cobs_decoder_init(&decoder, frame, sizeof(frame), EVENT_FRAME);
+
+	event_register(EVENT_UART_RX, receiver);
+	event_register(EVENT_UART_TX_END, on_tx_end);
+	event_register(EVENT_FRAME, on_frame);
+}
+
+void main(void)
+{
+	WDTCTL = WDTPW | WDTHOLD;
+
+	init_clocks();
+	systimer_init();
+	frames_init();
+
+	event_machine();
+}
@@ -0,0 +1,12 @@
+#ifndef USER_EVENTS_H
+#define USER_EVENTS_H
+
+#define EVENT_COUNT 4
+typedef enum user_events {
+	EVENT_SYS_TICK = 0,
+	EVENT_UART_RX,
+	EVENT_UART_TX_END,
+	EVENT_FRAME
+} event_id_t;
+
+#endif
@@ -0,0 +1,117 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include <msp430.h>
+#include "evm/include/event.h"
+#include "evm/include/systimer.h"
+
+/**************************   MODIFY   **************************************/
+/* Number of wake-ups to measure, one per systimer tick */
+#define BENCH_WAKEUPS     10240
+#define BENCH_MCLK_MHZ    16
+/* Active mode supply current at BENCH_MCLK_MHZ and the supply voltage, for
+ * the energy estimate. Approximate values for the FR5969, take them from the
+ * datasheet of your device: I(AM, FRAM) for code in FRAM, I(AM, RAM) for code
+ * in RAM */
+#define BENCH_UA_FRAM     1900
+#define BENCH_UA_RAM      1200
+#define BENCH_VCC_MV      3000
+/****************************************************************************/
+
+#ifdef EVENT_RAM_CODE
+#define BENCH_UA BENCH_UA_RAM
+#else
+#define BENCH_UA BENCH_UA_FRAM
+#endif
+
+typedef struct bench_result {
+	u32 wakeups;
+	u32 cycles;                // active MCLK cycles over all the wake-ups
+	u32 cycles_per_wakeup;
+	u32 nj_per_wakeup;         // estimated
+} bench_result_t;
+
+bench_result_t bench;
+
+static volatile u16 overflows;
+static u32 start;
+
+/* TB0 runs from SMCLK, which is stopped in LPM3 since its clock requests are
+ * disabled. So it only counts while the cpu is awake. */
+static u32 cycles_now(void)
+{
+	u32 now;
+
+	_uninterrupted(
+		now = TB0R;
+		// The overflow happened but its ISR has not run yet
+		if ((TB0CTL & TBIFG) && now < 0x8000)
+			now += 0x10000;
+		now += (u32)overflows << 16;
+	);
+	return now;
+}
+
+#pragma vector = TIMER0_B1_VECTOR
+__interrupt void TIMER0_B1_ISR(void)
+{
+	if (TB0IV == TB0IV_TBIFG)
+		++overflows;
+}
+
+EVM_RAMFUNC u16 bench_tick(int id, u16 latency)
+{
+	if (0 == bench.wakeups++) {
+		start = cycles_now();
+		return 1;
+	}
+
+	if (bench.wakeups <= BENCH_WAKEUPS)
+		return 1;
+
+	bench.wakeups = BENCH_WAKEUPS;
+	bench.cycles = cycles_now() - start;
+	bench.cycles_per_wakeup = bench.cycles / BENCH_WAKEUPS;
+	// nJ = uA * mV * cycles / MHz / 10^6
+	bench.nj_per_wakeup = (u32)((u64)BENCH_UA * BENCH_VCC_MV * bench.cycles
+	                            / BENCH_MCLK_MHZ / 1000000UL / BENCH_WAKEUPS);
+	// Put a breakpoint here and look at bench
+	__no_operation();
+	return 0;
+}
+
+void init_clocks(void)
+{
+	// LFXT on PJ.4/PJ.5
+	PJSEL0 |= BIT4 | BIT5;
+	PM5CTL0 &= ~LOCKLPM5;
+
+	// The FRAM needs a wait state above 8MHz
+	FRCTL0 = FRCTLPW | NWAITS_1;
+
+	CSCTL0_H = CSKEY_H;
+	CSCTL1 = DCORSEL | DCOFSEL_4;
+	CSCTL2 = SELA__LFXTCLK | SELS__DCOCLK | SELM__DCOCLK;
+	CSCTL3 = DIVA__1 | DIVS__1 | DIVM__1;
+	CSCTL4 &= ~LFXTOFF;
+	do {
+		CSCTL5 &= ~LFXTOFFG;
+		SFRIFG1 &= ~OFIFG;
+	} while (SFRIFG1 & OFIFG);
+	CSCTL6 &= ~SMCLKREQEN;
+	CSCTL0_H = 0;
+}
+
+void main(void)
+{
+	WDTCTL = WDTPW | WDTHOLD;
+
+	init_clocks();
+	TB0CTL = TBSSEL__SMCLK | MC__CONTINUOUS | TBCLR | TBIE;
+
+	systimer_init();
+	systimer_new_task(1, bench_tick, 0);
+	event_lpm_set(EVENT_LPM3);
+
+	event_machine();
+}
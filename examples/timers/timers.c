@@ -4,29 +4,37 @@
 #include <msp430.h>
 #include "evm/include/event.h"
 #include "evm/include/systimer.h"
+#include "evm/include/supervisor.h"
+
+#ifndef SUPERVISOR_ENABLE
+#error "define SUPERVISOR_ENABLE in supervisor.h, the example runs the watchdog with it"
+#endif
 
 uint sec_tick = 0;
+uint samples = 0;
+// The callback that overran its budget before the last reset
+pfn_t overran = Null;
 
-u16 feed_the_dog(int id, u16 latency)
+u16 sample(int id, u16 latency)
 {
-	WDTCTL = WDT_ARST_250;
+	++samples;
 	return 200;
 }
 
 u16 one_sec_tick(int id, u16 latency)
 {
-	if (++sec_tick == 10) {
-		WDTCTL = WDT_ARST_250;
-		systimer_new_task(200, feed_the_dog, 0);
-		return 0;
-	}
+	if (++sec_tick == 10)
+		systimer_new_task(200, sample, 0);
 
 	return SYS_TIME_OFFSET_LATENCY(SYS_TIME_SEC(1), latency);
 }
 
-void no_food_for_dog(void)
+/* Runs longer than SUPERVISOR_TIMER_BUDGET, the watchdog resets the device in
+ * the middle of it */
+void hog_the_cpu(void)
 {
-	systimer_delete_task(feed_the_dog, 0);
+	while (1)
+		;
 }
 
 void boot_delay(void)
@@ -36,12 +44,19 @@ void boot_delay(void)
 
 void main(void)
 {
-	WDTCTL = WDTPW | WDTHOLD;
+	bool reset = supervisor_init();
+
+	if (reset) {
+		// Put a breakpoint here, overran is hog_the_cpu
+		overran = supervisor_last()->timer;
+		_nop();
+	}
 
 	systimer_init();
 	systimer_new(5000, boot_delay);
-	// Or better use SYS_TIME_SEC for the exact seconds
-	systimer_new(SYS_TIME_SEC(30), no_food_for_dog);
+	// Only once after the power-up, or better use SYS_TIME_SEC for the exact seconds
+	if (!reset)
+		systimer_new(SYS_TIME_SEC(30), hog_the_cpu);
 
 	event_machine();
 }
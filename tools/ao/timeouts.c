@@ -0,0 +1,151 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* Checks the state timers of evm/ao.c on the host: a parent's timeout should
+ * run on while its substate's timeout expires and the substates change, and
+ * both should go to the states that own them.
+ *
+ *   gcc -std=gnu99 -O2 -DEVM_REPLAY -Wno-unknown-pragmas \
+ *       -include tools/ao/ao_events.h -Itools/replay -Ievm/include \
+ *       tools/ao/timeouts.c tools/replay/sim.c evm/event.c evm/systimer.c \
+ *       evm/ao.c -o timeouts
+ *   ./timeouts
+ *
+ * The machine, timeouts in systimer ticks:
+ *   busy(1000) -> rest(200) -> busy ...
+ *   busy: settle(300), its timeout handled in settle -> hold
+ *         hold, no timeout but handles AO_SIG_TIMEOUT too
+ * So the calls should be settle at 300, busy at 1000, rest at 1200, settle
+ * at 1500 and so on. The exit status is 0 if they are. */
+
+#include "sim.h"
+#include "event.h"
+#include "systimer.h"
+#include "ao.h"
+// After types.h, the system headers redefine its NULL quietly
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The timeouts are in systimer ticks */
+#define AT(ticks)   ((ticks) * 1000000000ull / SYS_TICK_IN_SEC)
+#define END         AT(3000)
+#define MAX_CALLS   16
+/* The ms to tick rounding and the tick the timer starts on */
+#define TOLERANCE   (2 * 1000000000ull / SYS_TICK_IN_SEC)
+
+#define SIG_COUNT   AO_SIG_USER
+
+typedef struct call {
+	const char *name;
+	u64         at;
+} call_t;
+
+static const call_t expected[] = {
+	{"settle", AT(300)},
+	{"busy",   AT(1000)},
+	{"rest",   AT(1200)},
+	{"settle", AT(1500)},
+	{"busy",   AT(2200)},
+	{"rest",   AT(2400)},
+	{"settle", AT(2700)},
+};
+
+static uint count;
+static call_t calls[MAX_CALLS];
+static bool woken;
+
+static void log_call(const char *name)
+{
+	if (count < MAX_CALLS) {
+		calls[count].name = name;
+		calls[count].at = sim_now;
+	}
+	++count;
+}
+
+/******************************* MACHINE ************************************/
+static void settle_timeout(ao_t *ao) { log_call("settle"); }
+static void hold_timeout(ao_t *ao)   { log_call("hold"); }
+static void busy_timeout(ao_t *ao)   { log_call("busy"); }
+static void rest_timeout(ao_t *ao)   { log_call("rest"); }
+
+extern const ao_state_t busy, settle, hold, rest;
+
+static const ao_transition_t busy_table[SIG_COUNT] = {
+	[AO_SIG_TIMEOUT] = {busy_timeout, &rest},
+};
+static const ao_transition_t settle_table[SIG_COUNT] = {
+	[AO_SIG_TIMEOUT] = {settle_timeout, &hold},
+};
+// A timeout of busy should not be taken here
+static const ao_transition_t hold_table[SIG_COUNT] = {
+	[AO_SIG_TIMEOUT] = {hold_timeout, Null},
+};
+static const ao_transition_t rest_table[SIG_COUNT] = {
+	[AO_SIG_TIMEOUT] = {rest_timeout, &busy},
+};
+
+const ao_state_t busy   = {Null, &settle, Null, Null, busy_table, 1000};
+const ao_state_t settle = {&busy, Null, Null, Null, settle_table, 300};
+const ao_state_t hold   = {&busy, Null, Null, Null, hold_table, 0};
+const ao_state_t rest   = {Null, Null, Null, Null, rest_table, 200};
+
+static ao_t machine;
+/****************************************************************************/
+
+static int check(void)
+{
+	uint i;
+	int failed = 0;
+
+	if (count != countof(expected)) {
+		printf("%u calls, expected %u\n", count, (uint)countof(expected));
+		failed = 1;
+	}
+	for (i = 0; i < count && i < MAX_CALLS && i < countof(expected); i++) {
+		u64 error = calls[i].at > expected[i].at ? calls[i].at - expected[i].at
+		                                         : expected[i].at - calls[i].at;
+
+		if (calls[i].name != expected[i].name || error > TOLERANCE) {
+			printf("call %u: %s at %.3f ms, expected %s at %.3f ms\n",
+			       i, calls[i].name, calls[i].at / 1e6,
+			       expected[i].name, expected[i].at / 1e6);
+			failed = 1;
+		}
+	}
+	printf("%u state timeouts checked: %s\n", i, failed ? "FAILED" : "ok");
+	return failed;
+}
+
+void sim_wake(void)
+{
+	woken = True;
+}
+
+void sim_sleep(unsigned int sr)
+{
+	u64 next;
+
+	woken = False;
+	while (!woken) {
+		sim_timers_poll();
+		next = sim_timers_next();
+		if (next > END)
+			exit(check());
+		if (next > sim_now)
+			sim_now = next;
+		sim_timers_fire();
+	}
+}
+
+void trace_dispatch_begin(uint id) {}
+void trace_dispatch_end(uint id) {}
+
+int main(void)
+{
+	systimer_init();
+	ao_init();
+	ao_start(&machine, &busy, SIG_COUNT);
+	event_machine();
+	return 0;
+}
@@ -0,0 +1,357 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* Runs a scenario on the event machine and the systimer compiled for the
+ * host, for hours of virtual time, and estimates the average current from
+ * where the cpu spent that time.
+ *
+ *   gcc -std=gnu99 -O2 -DEVM_REPLAY -Wno-unknown-pragmas \
+ *       -Itools/replay -Ievm/include tools/energy/energy.c \
+ *       tools/replay/sim.c evm/event.c evm/systimer.c scenario.c -o energy
+ *   ./energy hours=24 mhz=8 lpm3_ua=1.5 baseline_ua=2.1
+ *
+ * The arguments are key=value pairs of the model, or files of them one per
+ * line, see options[]. The active time is modelled in MCLK cycles, the host
+ * code is not timed:
+ * - wake_cycles for every wake-up from an LPM: the ISR entry and exit, the
+ *   event machine's loop and the way back to sleep.
+ * - isr_cycles for every ISR, woken up or not.
+ * - dispatch_cycles for every handler call, with a small handler.
+ * - And what the scenario adds with energy_busy.
+ * An LPM4 with a timer running is counted as LPM3, the timer keeps ACLK
+ * requested. With baseline_ua, the exit status is 2 when the average is
+ * above the baseline by more than tolerance percent. */
+
+#include "energy.h"
+#include "sim.h"
+#include "event.h"
+#include "systimer.h"
+// After types.h, the system headers redefine its NULL quietly
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LPM_COUNT 5
+#define IRQ_QUEUE 16
+
+/* The defaults are in the range of the F5xx datasheets at 3V, set the values
+ * of your device, clock and supply */
+typedef struct energy_model {
+	double hours;
+	double mhz;                  // MCLK
+	double active_ua_per_mhz;
+	double lpm_ua[LPM_COUNT];
+	double wake_cycles;
+	double isr_cycles;
+	double dispatch_cycles;
+	double baseline_ua;          // 0 for no comparison
+	double tolerance;            // percent
+} energy_model_t;
+
+static energy_model_t model = {
+	.hours             = 4,
+	.mhz               = 20.97,
+	.active_ua_per_mhz = 290,
+	.lpm_ua            = {90, 75, 6.5, 2.0, 1.1},
+	.wake_cycles       = 60,
+	.isr_cycles        = 40,
+	.dispatch_cycles   = 80,
+	.baseline_ua       = 0,
+	.tolerance         = 5,
+};
+
+typedef struct option {
+	const char *name;
+	double     *value;
+} option_t;
+
+static const option_t options[] = {
+	{"hours",             &model.hours},
+	{"mhz",               &model.mhz},
+	{"active_ua_per_mhz", &model.active_ua_per_mhz},
+	{"lpm0_ua",           &model.lpm_ua[0]},
+	{"lpm1_ua",           &model.lpm_ua[1]},
+	{"lpm2_ua",           &model.lpm_ua[2]},
+	{"lpm3_ua",           &model.lpm_ua[3]},
+	{"lpm4_ua",           &model.lpm_ua[4]},
+	{"wake_cycles",       &model.wake_cycles},
+	{"isr_cycles",        &model.isr_cycles},
+	{"dispatch_cycles",   &model.dispatch_cycles},
+	{"baseline_ua",       &model.baseline_ua},
+	{"tolerance",         &model.tolerance},
+};
+
+typedef struct energy_stats {
+	u64 wakeups;
+	u64 isrs;
+	u64 dispatches;
+	u64 cycles;                  // active
+	u64 active_ns;
+	u64 residency_ns[LPM_COUNT];
+} energy_stats_t;
+
+typedef struct sim_irq {
+	u64    at;
+	void (*isr)(void);
+} sim_irq_t;
+
+static energy_stats_t stats;
+static u64 end;
+static u64 pending;            // active cycles since the last wake-up
+static bool woken;
+static sim_irq_t irqs[IRQ_QUEUE];
+static uint irq_count;
+
+/******************************* MODEL **************************************/
+static u64 cycles_ns(u64 cycles)
+{
+	return (u64)(cycles * 1000.0 / model.mhz + 0.5);
+}
+
+static bool set_option(const char *arg)
+{
+	const char *eq = strchr(arg, '=');
+	size_t length;
+	uint i;
+
+	if (!eq)
+		return False;
+	for (length = eq - arg; length && strchr(" \t", arg[length - 1]); length--)
+		;
+	for (i = 0; i < countof(options); i++) {
+		if (strlen(options[i].name) == length
+		    && !strncmp(options[i].name, arg, length)) {
+			*options[i].value = atof(eq + 1);
+			return True;
+		}
+	}
+	fprintf(stderr, "unknown option %s\n", arg);
+	exit(1);
+}
+
+// A file of key=value lines, # starts a comment
+static void load_options(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[256];
+	char *p;
+
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if ((p = strchr(line, '#')))
+			*p = '\0';
+		for (p = line + strlen(line); p > line && strchr(" \t\r\n", p[-1]); p--)
+			p[-1] = '\0';
+		for (p = line; ' ' == *p || '\t' == *p; p++)
+			;
+		if (*p && !set_option(p)) {
+			fprintf(stderr, "%s: %s is not key=value\n", path, p);
+			exit(1);
+		}
+	}
+	fclose(f);
+}
+
+static uint lpm_of(unsigned int sr)
+{
+	if (sr & OSCOFF)
+		return 4;
+	switch (sr & (SCG1 | SCG0)) {
+		case 0:    return 0;
+		case SCG0: return 1;
+		case SCG1: return 2;
+		default:   return 3;
+	}
+}
+
+// The cpu runs, the virtual time goes on with it
+static void run(u64 cycles)
+{
+	u64 ns = cycles_ns(cycles);
+
+	stats.cycles += cycles;
+	stats.active_ns += ns;
+	sim_now += ns;
+}
+
+static void sleep_until(uint lpm, u64 until)
+{
+	if (4 == lpm && sim_timers_running())
+		lpm = 3;
+	stats.residency_ns[lpm] += until - sim_now;
+	sim_now = until;
+}
+/****************************************************************************/
+
+/******************************* STIMULUS ***********************************/
+static u64 irq_next(void)
+{
+	u64 next = SIM_NEVER;
+	uint i;
+
+	for (i = 0; i < irq_count; i++) {
+		if (irqs[i].at < next)
+			next = irqs[i].at;
+	}
+	return next;
+}
+
+// Runs the due ones in time order, an ISR may schedule new ones meanwhile
+static uint irq_fire(void)
+{
+	uint fired = 0;
+	uint first;
+	uint i;
+	void (*isr)(void);
+
+	while (irq_count) {
+		for (first = 0, i = 1; i < irq_count; i++) {
+			if (irqs[i].at < irqs[first].at)
+				first = i;
+		}
+		if (irqs[first].at > sim_now)
+			break;
+		isr = irqs[first].isr;
+		irqs[first] = irqs[--irq_count];
+		isr();
+		++fired;
+	}
+	return fired;
+}
+
+u64 energy_now(void)
+{
+	return sim_now + cycles_ns(pending);
+}
+
+void energy_irq(u64 at, void (*isr)(void))
+{
+	if (IRQ_QUEUE == irq_count) {
+		fprintf(stderr, "more than %u interrupts scheduled\n", IRQ_QUEUE);
+		exit(1);
+	}
+	irqs[irq_count].at = at;
+	irqs[irq_count].isr = isr;
+	++irq_count;
+}
+
+void energy_busy(u32 cycles)
+{
+	pending += cycles;
+}
+/****************************************************************************/
+
+static int report(void)
+{
+	double hours = sim_now / 3.6e12;
+	double charge;
+	double average;
+	uint i;
+
+	charge = stats.active_ns * model.active_ua_per_mhz * model.mhz;
+	for (i = 0; i < LPM_COUNT; i++)
+		charge += stats.residency_ns[i] * model.lpm_ua[i];
+	average = sim_now ? charge / sim_now : 0;
+
+	printf("scenario    %s\n", scenario_name);
+	printf("virtual     %.3f h\n", hours);
+	printf("wake-ups    %llu, %.1f per hour\n",
+	       (unsigned long long)stats.wakeups, stats.wakeups / hours);
+	printf("ISRs        %llu\n", (unsigned long long)stats.isrs);
+	printf("dispatches  %llu\n", (unsigned long long)stats.dispatches);
+	printf("active      %llu cycles at %.2f MHz, %.4f %%\n",
+	       (unsigned long long)stats.cycles, model.mhz,
+	       100.0 * stats.active_ns / sim_now);
+	for (i = 0; i < LPM_COUNT; i++) {
+		printf("LPM%u        %.4f %%\n", i,
+		       100.0 * stats.residency_ns[i] / sim_now);
+	}
+	printf("average     %.3f uA\n", average);
+
+	if (model.baseline_ua <= 0)
+		return 0;
+	printf("baseline    %.3f uA, %+.2f %%\n", model.baseline_ua,
+	       100.0 * (average - model.baseline_ua) / model.baseline_ua);
+	if (average > model.baseline_ua * (1 + model.tolerance / 100)) {
+		printf("over the baseline by more than %.1f %%\n", model.tolerance);
+		return 2;
+	}
+	return 0;
+}
+
+void sim_wake(void)
+{
+	woken = True;
+}
+
+void sim_sleep(unsigned int sr)
+{
+	uint lpm = lpm_of(sr);
+	bool slept = False;
+	u64 next;
+	u64 irq;
+	uint fired;
+
+	run(pending);
+	pending = 0;
+
+	woken = False;
+	while (!woken) {
+		sim_timers_poll();
+		next = sim_timers_next();
+		irq = irq_next();
+		if (irq < next)
+			next = irq;
+		if (next >= end) {
+			if (end > sim_now)
+				sleep_until(lpm, end);
+			exit(report());
+		}
+		if (next > sim_now) {
+			sleep_until(lpm, next);
+			slept = True;
+		}
+
+		fired = sim_timers_fire() + irq_fire();
+		stats.isrs += fired;
+		run((u64)(fired * model.isr_cycles));
+	}
+
+	// Woken up by an ISR that was due before the sleep, no wake-up then
+	if (slept) {
+		++stats.wakeups;
+		pending = (u64)model.wake_cycles;
+	}
+}
+
+void trace_dispatch_begin(uint id)
+{
+	++stats.dispatches;
+	pending += (u64)model.dispatch_cycles;
+}
+
+void trace_dispatch_end(uint id)
+{
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!set_option(argv[i]))
+			load_options(argv[i]);
+	}
+	if (model.hours <= 0 || model.mhz <= 0) {
+		fprintf(stderr, "hours and mhz should be positive\n");
+		return 1;
+	}
+	end = (u64)(model.hours * 3.6e12);
+
+	scenario_init();
+	event_machine();
+	return 0;
+}
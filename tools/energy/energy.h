@@ -0,0 +1,28 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include "types.h"
+
+/* The scenario side of the benchmark, instead of its main:
+ * - scenario_init sets up the application the same as its main does on the
+ *   device without the hardware setup, and schedules the first stimulus.
+ * - energy_irq runs isr at the virtual time at, in place of a peripheral
+ *   interrupt. The ISR schedules the next one itself if it repeats.
+ * - energy_busy adds the cycles of the work that the model doesn't see,
+ *   e.g. a loop over a received block in a handler. */
+
+#define ENERGY_US(us)  ((u64)(us) * 1000u)
+#define ENERGY_MS(ms)  ((u64)(ms) * 1000000u)
+#define ENERGY_SEC(s)  ((u64)(s) * 1000000000u)
+
+extern const char scenario_name[];
+void scenario_init(void);
+
+u64 energy_now(void);
+void energy_irq(u64 at, void (*isr)(void));
+void energy_busy(u32 cycles);
+
+#endif /* ENERGY_H */
@@ -0,0 +1,54 @@
+#!/bin/sh
+# Copyright (c) 2016 Kaan Mertol
+# Licensed under the MIT License. See the accompanying LICENSE file
+#
+# Builds and runs every scenario against tools/energy/baseline.txt, run from
+# the top of the repository. The arguments go to every run, e.g. hours=24 or
+# a model file. Exits nonzero if a scenario is over its baseline.
+#
+#   tools/energy/run.sh [key=value | model file]...
+#   tools/energy/run.sh --update    rewrites the baseline
+
+set -e
+
+DIR=tools/energy
+BUILD=${BUILD:-/tmp/evm-energy}
+CC=${CC:-gcc}
+UPDATE=
+if [ "$1" = "--update" ]; then
+	UPDATE=1
+	shift
+fi
+
+mkdir -p "$BUILD"
+if [ -n "$UPDATE" ]; then
+	echo "# Average uA of each scenario with the default model, run.sh --update" > "$BUILD/baseline.txt"
+fi
+status=0
+
+for scenario in timers debounce uart; do
+	include=
+	[ -f "$DIR/scenarios/${scenario}_events.h" ] && include="-include $DIR/scenarios/${scenario}_events.h"
+
+	$CC -std=gnu99 -O2 -DEVM_REPLAY -Wno-unknown-pragmas $include \
+	    -Itools/replay -Ievm/include -I$DIR \
+	    $DIR/energy.c tools/replay/sim.c evm/event.c evm/systimer.c \
+	    $DIR/scenarios/$scenario.c -o "$BUILD/$scenario"
+
+	baseline=
+	if [ -z "$UPDATE" ] && [ -f $DIR/baseline.txt ]; then
+		baseline=$(awk -v s=$scenario '$1 == s { print "baseline_ua=" $2 }' $DIR/baseline.txt)
+	fi
+
+	"$BUILD/$scenario" "$@" $baseline > "$BUILD/$scenario.txt" || status=1
+	cat "$BUILD/$scenario.txt"
+	echo
+	if [ -n "$UPDATE" ]; then
+		awk -v s=$scenario '$1 == "average" { print s, $2 }' "$BUILD/$scenario.txt" >> "$BUILD/baseline.txt"
+	fi
+done
+
+if [ -n "$UPDATE" ]; then
+	cp "$BUILD/baseline.txt" $DIR/baseline.txt
+fi
+exit $status
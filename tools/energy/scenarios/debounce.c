@@ -0,0 +1,95 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* examples/debounce: two inputs debounced with the systimer, sleeping in
+ * LPM4 in between. A button on input_0 is pressed every 10s and held for
+ * 300ms, a switch on input_1 is toggled every minute. The edges come after
+ * the debounce ends, so the bounces are left out, their interrupts are
+ * disabled on the device anyway.
+ *
+ * evm/debounce.c and evm/mspio.c are not compiled, the port is a plain
+ * variable and the debounce of the example is re-implemented here with the
+ * same timers. */
+
+#include "energy.h"
+#include "event.h"
+#include "systimer.h"
+
+#define BUTTON_PERIOD_MS  10000
+#define BUTTON_HOLD_MS    300
+#define SWITCH_PERIOD_MS  60000
+
+const char scenario_name[] = "debounce";
+
+typedef struct input {
+	u16  debounce;
+	u8   level;          // of the pin
+	u8   state;          // debounced
+	bool ie;
+} input_t;
+
+static input_t input[2] = {
+	{100, 1, 1, False},
+	{2000, 1, 1, False},
+};
+
+static u64 button_at;
+static u64 switch_at;
+
+static u16 on_debounce_end(int id, u16 latency)
+{
+	input_t *in = &input[id];
+
+	if (in->level != in->state)
+		in->state = in->level;
+	in->ie = True;
+	return 0;
+}
+
+// PORT2_ISR of the example
+static void edge(uint id, u8 level)
+{
+	input[id].level = level;
+	if (input[id].ie) {
+		input[id].ie = False;
+		systimer_new_task_isr(input[id].debounce, on_debounce_end, id);
+	}
+}
+
+static void button_release(void);
+
+static void button_press(void)
+{
+	edge(0, 0);
+	energy_irq(button_at + ENERGY_MS(BUTTON_HOLD_MS), button_release);
+}
+
+static void button_release(void)
+{
+	edge(0, 1);
+	button_at += ENERGY_MS(BUTTON_PERIOD_MS);
+	energy_irq(button_at, button_press);
+}
+
+static void switch_toggle(void)
+{
+	edge(1, input[1].level ^ 1);
+	switch_at += ENERGY_MS(SWITCH_PERIOD_MS);
+	energy_irq(switch_at, switch_toggle);
+}
+
+void scenario_init(void)
+{
+	uint i;
+
+	systimer_init();
+	// The initial state is debounced for 1ms, as mspio_init does
+	for (i = 0; i < countof(input); i++)
+		systimer_new_task(1, on_debounce_end, i);
+	event_lpm_set(EVENT_LPM4);
+
+	button_at = ENERGY_MS(BUTTON_PERIOD_MS);
+	switch_at = ENERGY_MS(SWITCH_PERIOD_MS);
+	energy_irq(button_at, button_press);
+	energy_irq(switch_at, switch_toggle);
+}
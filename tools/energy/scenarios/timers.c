@@ -0,0 +1,41 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* examples/timers: a boot delay, a task that keeps the exact seconds, and a
+ * 200ms task from the tenth second on. The supervisor and the callback that
+ * hogs the cpu are left out, the run goes on. The example stays in the
+ * default LPM0. */
+
+#include "energy.h"
+#include "event.h"
+#include "systimer.h"
+
+const char scenario_name[] = "timers";
+
+static uint sec_tick = 0;
+static uint samples = 0;
+
+static u16 sample(int id, u16 latency)
+{
+	++samples;
+	return 200;
+}
+
+static u16 one_sec_tick(int id, u16 latency)
+{
+	if (++sec_tick == 10)
+		systimer_new_task(200, sample, 0);
+
+	return SYS_TIME_OFFSET_LATENCY(SYS_TIME_SEC(1), latency);
+}
+
+static void boot_delay(void)
+{
+	systimer_new_task(SYS_TIME_SEC(1), one_sec_tick, 0);
+}
+
+void scenario_init(void)
+{
+	systimer_init();
+	systimer_new(5000, boot_delay);
+}
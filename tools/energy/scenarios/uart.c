@@ -0,0 +1,177 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* examples/uart: every line received is echoed back. A line arrives every
+ * second at UART_BAUD_RATE, the example stays in the default LPM0 for the
+ * uart's SMCLK.
+ *
+ * evm/uart.c is not compiled, its interrupts are modelled here with the same
+ * wake-ups: the start bit starts the idle poll, the DMA ends a block every
+ * UART_RX_BLOCK_SIZE chars, the idle poll flushes the rest of the line and
+ * the transmitter ends after the echo is on the line. Build with
+ * -include uart_events.h for the events of the example. */
+
+#include "energy.h"
+#include "event.h"
+#include "systimer.h"
+#include "uart.h"
+
+#define RECEPTION_TIMEOUT_MS    50
+#define LINE_SIZE               64
+#define LINE_PERIOD_MS          1000
+/* Cycles per char of the receiver's loop, beyond the dispatch */
+#define RECEIVER_CHAR_CYCLES    12
+
+// A start bit, 8 data bits and a stop bit
+#define CHAR_NS  (ENERGY_SEC(10) / UART_BAUD_RATE)
+
+const char scenario_name[] = "uart";
+
+static const char message[] = "t=21.5 rh=40 p=1013\n";
+#define MESSAGE_LENGTH (sizeof(message) - 1)
+
+static u8 line[LINE_SIZE];
+static uint index = 0;
+
+/******************************* UART MODEL *********************************/
+static u8 rx_ring[UART_RX_BUFFER_SIZE];
+static u16 rx_head;
+static u16 rx_tail;
+static u64 line_at;          // start bit of the line on the wire
+static u16 delivered;        // chars of the line that are in the ring
+static bool stt_ie = True;
+static u64 tx_free;          // when the transmitter runs out of data
+
+static u16 arrived(void)
+{
+	u64 chars = (energy_now() - line_at) / CHAR_NS;
+
+	return chars < MESSAGE_LENGTH ? (u16)chars : MESSAGE_LENGTH;
+}
+
+// rx_end_block of the driver
+static void rx_deliver(u16 count)
+{
+	while (count--)
+		rx_ring[rx_head++] = message[delivered++];
+	event_set(EVENT_UART_RX);
+}
+
+static void rx_block_end(void)
+{
+	rx_deliver(UART_RX_BLOCK_SIZE);
+	if (MESSAGE_LENGTH - delivered >= UART_RX_BLOCK_SIZE)
+		energy_irq(line_at + (delivered + UART_RX_BLOCK_SIZE) * CHAR_NS, rx_block_end);
+	__bic_SR_register_on_exit(LPM4_bits);
+}
+
+static u16 rx_idle_poll(int id, u16 latency)
+{
+	static u16 last;
+	u16 chars = arrived();
+
+	if (chars != last) {
+		last = chars;
+		return UART_RX_IDLE_MS;
+	}
+	if (chars > delivered)
+		rx_deliver(chars - delivered);
+	stt_ie = True;
+	last = 0;
+	return 0;
+}
+
+static void line_begin(void);
+
+static void rx_start_bit(void)
+{
+	delivered = 0;
+	if (stt_ie) {
+		stt_ie = False;
+		systimer_new_task_isr(UART_RX_IDLE_MS, rx_idle_poll, 0);
+	}
+	if (MESSAGE_LENGTH >= UART_RX_BLOCK_SIZE)
+		energy_irq(line_at + UART_RX_BLOCK_SIZE * CHAR_NS, rx_block_end);
+	energy_irq(line_at + ENERGY_MS(LINE_PERIOD_MS), line_begin);
+}
+
+static void line_begin(void)
+{
+	line_at += ENERGY_MS(LINE_PERIOD_MS);
+	rx_start_bit();
+}
+
+static void tx_end(void)
+{
+	event_set_isr(EVENT_UART_TX_END);
+}
+
+u16 uart_rx_peek(const u8 **data)
+{
+	*data = &rx_ring[rx_tail];
+	return rx_head - rx_tail;
+}
+
+void uart_rx_commit(u16 length)
+{
+	rx_tail += length;
+	if (rx_tail == rx_head)
+		rx_tail = rx_head = 0;
+}
+
+u16 uart_write(const void *data, u16 length)
+{
+	u64 now = energy_now();
+
+	if (tx_free < now)
+		tx_free = now;
+	tx_free += length * CHAR_NS;
+	energy_irq(tx_free, tx_end);
+	return length;
+}
+/****************************************************************************/
+
+static void on_tx_end(void)
+{
+}
+
+static void reception_timeout(void)
+{
+	index = 0;
+}
+
+// The receiver of the example
+static void receiver(void)
+{
+	const u8 *data;
+	u16 length;
+	u16 i;
+
+	while (0 != (length = uart_rx_peek(&data))) {
+		energy_busy(length * RECEIVER_CHAR_CYCLES);
+		for (i = 0; i < length; i++) {
+			line[index++] = data[i];
+			if (data[i] == '\n') {
+				uart_write(line, index);
+				index = 0;
+				systimer_delete(reception_timeout);
+			} else {
+				if (index == 1)
+					systimer_renew(RECEPTION_TIMEOUT_MS, reception_timeout);
+				if (index >= LINE_SIZE)
+					index = 0;
+			}
+		}
+		uart_rx_commit(length);
+	}
+}
+
+void scenario_init(void)
+{
+	systimer_init();
+	event_register(EVENT_UART_RX, receiver);
+	event_register(EVENT_UART_TX_END, on_tx_end);
+
+	line_at = ENERGY_MS(LINE_PERIOD_MS);
+	energy_irq(line_at, rx_start_bit);
+}
@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# Copyright (c) 2016 Kaan Mertol
+# Licensed under the MIT License. See the accompanying LICENSE file
+"""Formats the tokenized log records of evm/log.c on the host.
+
+The format strings are read from the .logstr section of the output file,
+the records are read from a capture file or stdin, e.g.
+
+    python3 tools/logdecode.py project.out capture.bin
+    cat /dev/ttyACM0 | python3 tools/logdecode.py project.out -
+"""
+
+import re
+import struct
+import sys
+
+LOG_ID_DROPPED = 0xFFFF
+CONVERSION = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(h|l)?([diouxXc%])')
+
+
+def read_strings(path, section='.logstr'):
+    """Returns {id: format} from the ELF32 output file"""
+    with open(path, 'rb') as f:
+        elf = f.read()
+    if elf[:4] != b'\x7fELF' or elf[4] != 1:
+        sys.exit('%s is not an ELF32 file' % path)
+    endian = '<' if elf[5] == 1 else '>'
+    shoff, = struct.unpack_from(endian + 'I', elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', elf, 0x2E)
+
+    def header(i):
+        return struct.unpack_from(endian + 'IIIIIIIIII', elf, shoff + i * shentsize)
+
+    names = header(shstrndx)[4]
+    for i in range(shnum):
+        name, _, _, addr, offset, size = header(i)[:6]
+        end = elf.index(b'\0', names + name)
+        if elf[names + name:end].decode() != section:
+            continue
+        strings = {}
+        data = elf[offset:offset + size]
+        start = 0
+        while start < len(data):
+            end = data.find(b'\0', start)
+            if end < 0:
+                end = len(data)
+            if end > start:
+                strings[(addr + start) & 0xFFFF] = data[start:end].decode('latin-1')
+            start = end + 1
+        return strings
+    sys.exit('no %s section in %s, is LOG_ENABLE defined?' % (section, path))
+
+
+def read_words(stream, count):
+    data = stream.read(2 * count)
+    if len(data) < 2 * count:
+        raise EOFError
+    return struct.unpack('<%dH' % count, data)
+
+
+def format_record(fmt, stream):
+    args = []
+    for size, conv in CONVERSION.findall(fmt):
+        if conv == '%':
+            continue
+        if size == 'l':
+            low, high = read_words(stream, 2)
+            value, bits = low | high << 16, 32
+        else:
+            value, bits = read_words(stream, 1)[0], 16
+        if conv in 'di' and value >> (bits - 1):
+            value -= 1 << bits
+        args.append(chr(value & 0xFF) if conv == 'c' else value)
+    # Python's % doesn't know the size modifiers
+    return CONVERSION.sub(lambda m: m.group(0).replace(m.group(1), '', 1)
+                          if m.group(1) else m.group(0), fmt) % tuple(args)
+
+
+def decode(strings, stream):
+    while True:
+        try:
+            record_id, = read_words(stream, 1)
+            if record_id == LOG_ID_DROPPED:
+                print('<%d records dropped>' % read_words(stream, 1))
+            elif record_id in strings:
+                print(format_record(strings[record_id], stream))
+            else:
+                # The stream can't be resynchronized without the record length
+                sys.exit('unknown record id 0x%04X, wrong output file?' % record_id)
+        except EOFError:
+            return
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    strings = read_strings(sys.argv[1])
+    if sys.argv[2] == '-':
+        decode(strings, sys.stdin.buffer)
+    else:
+        with open(sys.argv[2], 'rb') as stream:
+            decode(strings, stream)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,324 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* Checks the systimer checkpoint that the lpm5 module is built on, on the
+ * host: the timers that are saved, slept over and restored should be called
+ * when they would have been called without the sleep.
+ *
+ *   gcc -std=gnu99 -O2 -DEVM_REPLAY -DSYS_TIMER_CHECKPOINT \
+ *       -DSYS_TIMER_PERIODIC -Wno-unknown-pragmas \
+ *       -include tools/lpm5/registers.h \
+ *       -include tools/lpm5/checkpoint_events.h -Itools/replay -Ievm/include \
+ *       tools/lpm5/checkpoint.c tools/replay/sim.c evm/event.c \
+ *       evm/systimer.c evm/lpm5.c -o checkpoint
+ *   ./checkpoint
+ *
+ * First lpm5_sleep itself should refuse to enter LPMx.5 while an event is
+ * pending, and enter it when none is.
+ *
+ * Then the same timers run three times, each run in its own process, so the
+ * last one starts from a clean RAM as the wake-up does:
+ * - The reference never sleeps.
+ * - The second saves from the EVENT_SAVE handler and ends there, as
+ *   lpm5_sleep does. Before that, a save from a timer callback should fail.
+ * - The third starts at the earliest deadline of the save, restores and
+ *   runs on. Its calls should match the calls of the reference after the
+ *   save, within a tick.
+ * The exit status is 0 if all of them pass. */
+
+#include "sim.h"
+#include "event.h"
+#include "systimer.h"
+#include "lpm5.h"
+// After types.h, the system headers redefine its NULL quietly
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define END         (10 * 1000000000ull)
+#define MAX_CALLS   256
+#define MAX_TIMERS  8
+/* The restored timers start with the next tick after the wake-up, a tick late
+ * at most, and the ms to tick rounding */
+#define TOLERANCE   (2 * 1000000000ull / SYS_TICK_IN_SEC)
+
+typedef enum run {
+	RUN_REFERENCE = 0,
+	RUN_SAVE,
+	RUN_RESTORE
+} run_t;
+
+typedef struct call {
+	const char *name;
+	u64         at;
+} call_t;
+
+typedef struct call_log {
+	uint   count;
+	call_t call[MAX_CALLS];
+} call_log_t;
+
+typedef struct saved {
+	int               count;      // -1 if the save failed
+	int               in_callback;
+	u32               earliest;
+	u64               at;
+	systimer_record_t timer[MAX_TIMERS];
+} saved_t;
+
+extern volatile event_reg_t event_list;
+
+volatile unsigned char RTCCTL0_H, RTCCTL0_L, PMMCTL0_H, PMMCTL0_L;
+volatile unsigned int RTCCTL13, RTCPS1CTL, RTCNT12, RTCNT34;
+volatile unsigned int PMMIFG, PM5CTL0;
+
+static run_t run;
+static int out;                 // pipe to the checking process
+static bool woken;
+static bool entered_lpm5;
+static call_log_t calls;
+static saved_t saved;
+
+static void log_call(const char *name)
+{
+	if (calls.count < MAX_CALLS) {
+		calls.call[calls.count].name = name;
+		calls.call[calls.count].at = sim_now;
+		++calls.count;
+	}
+}
+
+static void send_result(const void *data, size_t size)
+{
+	if (write(out, data, size) != (ssize_t)size)
+		_exit(1);
+}
+
+static void receive(int in, void *data, size_t size)
+{
+	u8 *bytes = data;
+	ssize_t got;
+
+	while (size) {
+		got = read(in, bytes, size);
+		if (got <= 0) {
+			fprintf(stderr, "a run ended without its result\n");
+			exit(1);
+		}
+		bytes += got;
+		size -= got;
+	}
+}
+
+/******************************* TIMERS *************************************/
+static void wake_alarm(void)
+{
+	log_call("wake_alarm");
+}
+
+static u16 beat(int id, u16 latency)
+{
+	log_call("beat");
+	return SYS_TIME_OFFSET_LATENCY(700, latency);
+}
+
+static void tick(int id)
+{
+	log_call("tick");
+}
+
+static void request_save(void)
+{
+	u32 earliest;
+
+	log_call("request_save");
+	saved.in_callback = _systimer_save(saved.timer, MAX_TIMERS, &earliest);
+	event_set(EVENT_SAVE);
+}
+
+static void save(void)
+{
+	if (RUN_SAVE != run)
+		return;
+
+	// As lpm5_sleep, only with no event pending, try again after them
+	if (event_list) {
+		event_set(EVENT_SAVE);
+		return;
+	}
+	_uninterrupted(
+		saved.count = _systimer_save(saved.timer, MAX_TIMERS, &saved.earliest);
+	);
+	saved.at = sim_now;
+	send_result(&saved, sizeof(saved));
+	_exit(0);
+}
+/****************************************************************************/
+
+static void start_timers(void)
+{
+	systimer_new(3000, wake_alarm);
+	systimer_new_task(700, beat, 0);
+	systimer_new_periodic(250, tick, 0);
+	systimer_new(1100, request_save);
+}
+
+// lpm5_sleep should not leave a pending event behind in LPMx.5
+static int check_pending(void)
+{
+	bool slept;
+	int failed = 0;
+
+	systimer_init();
+	start_timers();
+
+	event_set(EVENT_SAVE);
+	slept = lpm5_sleep();
+	if (slept || entered_lpm5) {
+		printf("lpm5_sleep entered LPMx.5 with an event pending\n");
+		failed = 1;
+	}
+
+	event_list = 0;
+	lpm5_sleep();
+	if (!entered_lpm5) {
+		printf("lpm5_sleep did not enter LPMx.5 with no event pending\n");
+		failed = 1;
+	}
+
+	printf("lpm5_sleep with a pending event: %s\n", failed ? "FAILED" : "ok");
+	return failed;
+}
+
+static int check(const call_log_t *reference)
+{
+	const call_t *expected = reference->call;
+	const call_t *end = expected + reference->count;
+	uint i;
+	int failed = 0;
+
+	if (saved.in_callback != -1) {
+		printf("a save from a timer callback returned %d, not -1\n", saved.in_callback);
+		failed = 1;
+	}
+
+	while (expected < end && expected->at <= saved.at)
+		++expected;
+	// A call late by a tick at the end may not make it into the run
+	while (end > expected && end[-1].at + TOLERANCE > END)
+		--end;
+	if (calls.count < (uint)(end - expected)) {
+		printf("%u calls after the restore, the reference has %u\n",
+		       calls.count, (uint)(end - expected));
+		failed = 1;
+	}
+	for (i = 0; i < calls.count && expected < end; i++, expected++) {
+		const call_t *c = &calls.call[i];
+		u64 error = c->at > expected->at ? c->at - expected->at : expected->at - c->at;
+
+		if (c->name != expected->name || error > TOLERANCE) {
+			printf("call %u: %s at %.3f ms, the reference has %s at %.3f ms\n",
+			       i, c->name, c->at / 1e6, expected->name, expected->at / 1e6);
+			failed = 1;
+		}
+	}
+
+	printf("saved %d timers at %.3f ms, woke up at %.3f ms, %u calls checked: %s\n",
+	       saved.count, saved.at / 1e6,
+	       (saved.at + sim_ns((u64)saved.earliest * (SIM_ACLK_HZ / SYS_TICK_IN_SEC))) / 1e6,
+	       i, failed ? "FAILED" : "ok");
+	return failed;
+}
+
+static call_log_t reference;
+
+void sim_wake(void)
+{
+	woken = True;
+}
+
+void sim_sleep(unsigned int sr)
+{
+	u64 next;
+
+	// The regulator is off only on the way into LPMx.5, return as if an
+	// interrupt came in meanwhile
+	if (PMMCTL0_L & PMMREGOFF) {
+		entered_lpm5 = True;
+		return;
+	}
+
+	woken = False;
+	while (!woken) {
+		sim_timers_poll();
+		next = sim_timers_next();
+		if (next > END) {
+			if (RUN_REFERENCE == run) {
+				send_result(&calls, sizeof(calls));
+				_exit(0);
+			}
+			exit(check(&reference));
+		}
+		if (next > sim_now)
+			sim_now = next;
+		sim_timers_fire();
+	}
+}
+
+void trace_dispatch_begin(uint id) {}
+void trace_dispatch_end(uint id) {}
+
+int main(void)
+{
+	int fds[2];
+	int status;
+	pid_t pid;
+	run_t which;
+
+	if ((pid = fork()) < 0) {
+		perror("checkpoint");
+		return 1;
+	}
+	if (0 == pid)
+		exit(check_pending());
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+		return 1;
+
+	for (which = RUN_REFERENCE; which <= RUN_SAVE; which++) {
+		if (pipe(fds) || (pid = fork()) < 0) {
+			perror("checkpoint");
+			return 1;
+		}
+		if (0 == pid) {
+			close(fds[0]);
+			out = fds[1];
+			run = which;
+			systimer_init();
+			event_register(EVENT_SAVE, save);
+			start_timers();
+			event_machine();
+		}
+		close(fds[1]);
+		if (RUN_REFERENCE == which)
+			receive(fds[0], &reference, sizeof(reference));
+		else
+			receive(fds[0], &saved, sizeof(saved));
+		close(fds[0]);
+		waitpid(pid, Null, 0);
+	}
+
+	if (saved.count < 0) {
+		printf("the save failed\n");
+		return 1;
+	}
+
+	// The RTC woke the device up at the earliest deadline
+	run = RUN_RESTORE;
+	sim_now = saved.at + sim_ns((u64)saved.earliest * (SIM_ACLK_HZ / SYS_TICK_IN_SEC));
+	systimer_init();
+	event_register(EVENT_SAVE, save);
+	_systimer_restore(saved.timer, saved.count, saved.earliest);
+	event_machine();
+	return 0;
+}
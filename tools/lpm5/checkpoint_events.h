@@ -0,0 +1,10 @@
+#ifndef USER_EVENTS_H
+#define USER_EVENTS_H
+
+#define EVENT_COUNT 2
+typedef enum user_events {
+	EVENT_SYS_TICK = 0,
+	EVENT_SAVE
+} event_id_t;
+
+#endif
@@ -0,0 +1,30 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* The RTC_C and PMM registers of evm/lpm5.c for tools/lpm5/checkpoint.c,
+ * plain variables defined there. Include before anything else. */
+
+#ifndef LPM5_REGISTERS_H
+#define LPM5_REGISTERS_H
+
+#define RTCKEY_H     0xA5
+#define RTCHOLD      0x4000
+#define RTCSSEL_2    0x0800
+#define RTCTEV_3     0x0300
+#define RTCTEVIE     0x0040
+#define RTCTEVIFG    0x0004
+#define RT1SSEL_0    0x0000
+#define RT1PSDIV_4   0x0010
+#define PMMPW_H      0xA5
+#define PMMREGOFF    0x0010
+#define PMMLPM5IFG   0x8000
+#define LOCKLPM5     0x0001
+
+// The TI intrinsic behind offsetof in types.h
+#define __intaddr__(address) ((unsigned long)(address))
+
+extern volatile unsigned char RTCCTL0_H, RTCCTL0_L, PMMCTL0_H, PMMCTL0_L;
+extern volatile unsigned int RTCCTL13, RTCPS1CTL, RTCNT12, RTCNT34;
+extern volatile unsigned int PMMIFG, PM5CTL0;
+
+#endif /* LPM5_REGISTERS_H */
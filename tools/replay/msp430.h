@@ -0,0 +1,53 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* Stands in for the device header when the event machine and the systimer
+ * are compiled for the host by tools/replay and tools/energy. Only what evm
+ * needs is here, the registers are plain variables defined in sim.c. Add the
+ * registers your handlers touch to a header of your own. */
+
+#ifndef REPLAY_MSP430_H
+#define REPLAY_MSP430_H
+
+#define GIE     0x0008
+#define CPUOFF  0x0010
+#define OSCOFF  0x0020
+#define SCG0    0x0040
+#define SCG1    0x0080
+
+#define LPM0_bits (CPUOFF)
+#define LPM1_bits (SCG0 | CPUOFF)
+#define LPM2_bits (SCG1 | CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+#define LPM4_bits (SCG1 | SCG0 | CPUOFF | OSCOFF)
+
+#define TACLR    0x0004
+#define TAIE     0x0002
+#define TAIFG    0x0001
+#define MC0      0x0010
+#define MC1      0x0020
+#define MC_1     0x0010
+#define MC_2     0x0020
+#define TASSEL_1 0x0100
+#define CCIE     0x0010
+#define CCIFG    0x0001
+
+extern volatile unsigned int TA1CTL, TA1CCTL0, TA1CCR0, TA1R;
+extern volatile unsigned int TA2CTL, TA2CCTL0, TA2CCR0, TA2R;
+
+/* Every sleep entry of the event machine is where the tool advances the
+ * virtual time and runs the ISRs, see sim.h */
+void sim_sleep(unsigned int sr);
+void sim_wake(void);
+
+#define __bis_SR_register(sr)           sim_sleep(sr)
+#define __bic_SR_register_on_exit(sr)   sim_wake()
+#define __disable_interrupt()           ((void)0)
+#define __enable_interrupt()            ((void)0)
+#define __get_interrupt_state()         0u
+#define __set_interrupt_state(state)    ((void)(state))
+#define __no_operation()                ((void)0)
+#define __delay_cycles(cycles)          ((void)0)
+#define __interrupt
+
+#endif /* REPLAY_MSP430_H */
@@ -0,0 +1,320 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+/* Replays a stream recorded by evm/trace.c into the event machine and the
+ * systimer compiled for the host, and reports the dispatch latency and the
+ * run time of every event's handlers.
+ *
+ *   gcc -std=gnu99 -O2 -DEVM_REPLAY -Wno-unknown-pragmas \
+ *       -Itools/replay -Ievm/include tools/replay/replay.c \
+ *       tools/replay/sim.c evm/event.c evm/systimer.c app_handlers.c -o replay
+ *   nm project.out > symbols.txt
+ *   ./replay capture.bin symbols.txt
+ *
+ * The virtual time only advances while the event machine sleeps: the recorded
+ * events and the systimer ticks are replayed in order, at the sleep entries.
+ * The latencies and the handler times are measured in host time, compare them
+ * between the builds of the same application. */
+
+#include "replay.h"
+#include "sim.h"
+#include "event.h"
+#include "systimer.h"
+#include "trace.h"
+// After types.h, the system headers redefine its NULL quietly
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern volatile event_reg_t event_list;
+
+typedef struct symbol {
+	u16         address;
+	const char *name;
+} symbol_t;
+
+typedef struct event_stats {
+	u32 count;
+	u64 handler_ns;
+	u64 handler_max_ns;
+	u64 latency_ns;
+	u64 latency_max_ns;
+} event_stats_t;
+
+static u16 *trace;
+static size_t trace_words;
+static size_t trace_pos;
+static u64 record_time;      // ACLK ticks of the record at trace_pos
+static u32 dropped;
+
+static symbol_t *symbols;
+static size_t symbol_count;
+
+static bool woken;
+static u64 set_ns[EVENT_COUNT];
+static u64 begin_ns;
+static event_reg_t before;
+static event_stats_t stats[EVENT_COUNT];
+static u32 records;
+static u32 skipped;
+
+static u64 host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/******************************* INPUT **************************************/
+static void load_trace(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	long size;
+	size_t i;
+	u8 *bytes;
+
+	if (!f || fseek(f, 0, SEEK_END) || (size = ftell(f)) < 0) {
+		perror(path);
+		exit(1);
+	}
+	rewind(f);
+	bytes = malloc(size + 1);
+	if (!bytes || fread(bytes, 1, size, f) != (size_t)size) {
+		perror(path);
+		exit(1);
+	}
+	fclose(f);
+
+	// The stream is little endian regardless of the host
+	trace_words = size / 2;
+	trace = malloc(trace_words * sizeof(u16) + 1);
+	for (i = 0; i < trace_words; i++)
+		trace[i] = bytes[2 * i] | bytes[2 * i + 1] << 8;
+	free(bytes);
+}
+
+// Takes the nm output: "<hex address> <type> <name>"
+static void load_symbols(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[512];
+	char name[256];
+	char type[8];
+	unsigned long address;
+	size_t size = 0;
+
+	if (!f) {
+		perror(path);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		if (3 != sscanf(line, "%lx %7s %255s", &address, type, name))
+			continue;
+		if (symbol_count == size) {
+			size = size ? 2 * size : 256;
+			symbols = realloc(symbols, size * sizeof(symbol_t));
+		}
+		symbols[symbol_count].address = (u16)address;
+		symbols[symbol_count].name = strdup(name);
+		++symbol_count;
+	}
+	fclose(f);
+}
+
+static pfn_t host_callback(u16 address)
+{
+	const replay_symbol_t *r;
+	size_t i;
+
+	for (i = 0; i < symbol_count; i++) {
+		if (symbols[i].address != address)
+			continue;
+		for (r = replay_symbols; r->name; r++) {
+			// TI tools prefix the C names with an underscore in some modes
+			const char *name = symbols[i].name;
+			if (!strcmp(r->name, name) || ('_' == name[0] && !strcmp(r->name, name + 1)))
+				return r->fn;
+		}
+	}
+	fprintf(stderr, "no host callback for 0x%04x, the timer is skipped\n", address);
+	return Null;
+}
+
+// Moves past the gaps and the drops, to the next record that does something
+static void trace_seek(void)
+{
+	while (trace_pos + 2 <= trace_words) {
+		u16 delta = trace[trace_pos];
+		u16 type = trace[trace_pos + 1];
+
+		if (TRACE_GAP == (type & TRACE_TYPE_MASK)) {
+			record_time += (u64)delta << 16;
+		} else if (TRACE_DROP == (type & TRACE_TYPE_MASK)) {
+			record_time += delta;
+			dropped += type & ~TRACE_TYPE_MASK;
+		} else {
+			return;
+		}
+		trace_pos += 2;
+	}
+}
+
+static bool trace_pending(void)
+{
+	trace_seek();
+	return trace_pos + 2 <= trace_words;
+}
+
+static u64 trace_next_time(void)
+{
+	return trace_pending() ? sim_ns(record_time + trace[trace_pos]) : SIM_NEVER;
+}
+
+// Applies the record at trace_pos, the same as its ISR did on the device
+static void trace_apply(void)
+{
+	u16 type = trace[trace_pos + 1];
+	uint arg = type & ~TRACE_TYPE_MASK;
+	u16 *data = &trace[trace_pos + 2];
+	pfn_t fn;
+
+	record_time += trace[trace_pos];
+	trace_pos += 2;
+	++records;
+
+	switch (type & TRACE_TYPE_MASK) {
+	case TRACE_EVENT:
+		if (arg < EVENT_COUNT) {
+			event_set((event_id_t)arg);
+			sim_wake();
+		} else {
+			++skipped;
+		}
+		break;
+	case TRACE_TIMER:
+		if (trace_pos + 3 > trace_words) {
+			trace_pos = trace_words;
+			break;
+		}
+		trace_pos += 3;
+		fn = host_callback(data[1]);
+		if (fn && arg < SYS_DOMAIN_COUNT)
+			_systimer_new_isr((sys_domain_t)arg, data[0], (tcb_noid_t)fn, (s16)data[2]);
+		else
+			++skipped;
+		break;
+	default:
+		++skipped;
+		break;
+	}
+}
+/****************************************************************************/
+
+static void report(void)
+{
+	uint i;
+
+	printf("replayed %lu records, %lu skipped, %lu dropped on the device, "
+	       "%.3f s of virtual time\n", (unsigned long)records,
+	       (unsigned long)skipped, (unsigned long)dropped, sim_now / 1e9);
+	printf("%5s %10s %12s %12s %12s %12s\n", "event", "count",
+	       "handler avg", "handler max", "latency avg", "latency max");
+	for (i = 0; i < EVENT_COUNT; i++) {
+		event_stats_t *s = &stats[i];
+
+		if (!s->count)
+			continue;
+		printf("%5u %10lu %12llu %12llu %12llu %12llu\n", i,
+		       (unsigned long)s->count,
+		       (unsigned long long)(s->handler_ns / s->count),
+		       (unsigned long long)s->handler_max_ns,
+		       (unsigned long long)(s->latency_ns / s->count),
+		       (unsigned long long)s->latency_max_ns);
+	}
+	printf("times in ns\n");
+}
+
+// Marks the pending events that were not pending before as set now
+static void mark_set(event_reg_t previous, u64 ns)
+{
+	event_reg_t set = event_list & ~previous;
+	uint i;
+
+	for (i = 0; i < EVENT_COUNT; i++) {
+		if (set & ((event_reg_t)1 << i))
+			set_ns[i] = ns;
+	}
+}
+
+void sim_wake(void)
+{
+	woken = True;
+}
+
+void sim_sleep(unsigned int sr)
+{
+	u64 next;
+	u64 timer;
+
+	woken = False;
+	while (!woken) {
+		sim_timers_poll();
+		if (!trace_pending()) {
+			report();
+			exit(0);
+		}
+
+		next = trace_next_time();
+		timer = sim_timers_next();
+		sim_now = (timer < next) ? timer : next;
+
+		sim_timers_fire();
+		while (trace_next_time() <= sim_now)
+			trace_apply();
+	}
+	mark_set(0, host_ns());
+}
+
+void trace_dispatch_begin(uint id)
+{
+	u64 ns = host_ns();
+	u64 latency = ns - set_ns[id];
+	event_stats_t *s = &stats[id];
+
+	++s->count;
+	s->latency_ns += latency;
+	if (latency > s->latency_max_ns)
+		s->latency_max_ns = latency;
+	before = event_list;
+	begin_ns = ns;
+}
+
+void trace_dispatch_end(uint id)
+{
+	u64 ns = host_ns();
+	u64 elapsed = ns - begin_ns;
+	event_stats_t *s = &stats[id];
+
+	s->handler_ns += elapsed;
+	if (elapsed > s->handler_max_ns)
+		s->handler_max_ns = elapsed;
+	// The events set by the handler are pending from now on
+	mark_set(before, ns);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s trace.bin [symbols.txt]\n", argv[0]);
+		return 1;
+	}
+	load_trace(argv[1]);
+	if (argc > 2)
+		load_symbols(argv[2]);
+
+	replay_init();
+	event_machine();
+	return 0;
+}
@@ -0,0 +1,24 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "types.h"
+
+/* The application side of the replay, instead of its main:
+ * - replay_init registers the handlers and creates the initial timers, the
+ *   same as the main does on the device without the hardware setup.
+ * - replay_symbols maps the names of the timer callbacks that are created
+ *   from the ISRs to their host functions, ending with {Null, Null}. */
+typedef struct replay_symbol {
+	const char *name;
+	pfn_t       fn;
+} replay_symbol_t;
+
+#define REPLAY_SYMBOL(fn) { #fn, (pfn_t)(fn) }
+
+extern const replay_symbol_t replay_symbols[];
+void replay_init(void);
+
+#endif /* REPLAY_H */
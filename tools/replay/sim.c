@@ -0,0 +1,94 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#include "sim.h"
+#include "systimer.h"
+#include <msp430.h>
+
+volatile unsigned int TA1CTL, TA1CCTL0, TA1CCR0, TA1R;
+volatile unsigned int TA2CTL, TA2CCTL0, TA2CCR0, TA2R;
+
+u64 sim_now;
+
+extern void TIMER1_A0_ISR(void);
+#ifdef SYS_SLOW_DOMAIN
+extern void TIMER2_A0_ISR(void);
+#endif
+
+/* An up mode timer fires every CCR0+1 ticks after its start. The expiries
+ * are counted in ticks from the start, so the ns rounding never adds up. */
+typedef struct sim_timer {
+	volatile unsigned int *ctl;
+	volatile unsigned int *cctl;
+	volatile unsigned int *ccr;
+	void                 (*isr)(void);
+	bool                   running;
+	u64                    start;
+	u64                    ticks;
+} sim_timer_t;
+
+static sim_timer_t timers[] = {
+	{&TA1CTL, &TA1CCTL0, &TA1CCR0, TIMER1_A0_ISR, False, 0, 0},
+#ifdef SYS_SLOW_DOMAIN
+	{&TA2CTL, &TA2CCTL0, &TA2CCR0, TIMER2_A0_ISR, False, 0, 0},
+#endif
+};
+
+static u64 timer_next(const sim_timer_t *t)
+{
+	return t->start + sim_ns(t->ticks + *t->ccr + 1);
+}
+
+void sim_timers_poll(void)
+{
+	sim_timer_t *t;
+
+	for (t = timers; t < timers + countof(timers); t++) {
+		bool running = (*t->ctl & (MC0 | MC1)) && (*t->cctl & CCIE);
+
+		if (running && (!t->running || (*t->ctl & TACLR))) {
+			t->start = sim_now;
+			t->ticks = 0;
+		}
+		*t->ctl &= ~TACLR;
+		t->running = running;
+	}
+}
+
+u64 sim_timers_next(void)
+{
+	sim_timer_t *t;
+	u64 next = SIM_NEVER;
+
+	for (t = timers; t < timers + countof(timers); t++) {
+		if (t->running && timer_next(t) < next)
+			next = timer_next(t);
+	}
+	return next;
+}
+
+uint sim_timers_fire(void)
+{
+	sim_timer_t *t;
+	uint fired = 0;
+
+	for (t = timers; t < timers + countof(timers); t++) {
+		if (t->running && timer_next(t) <= sim_now) {
+			t->ticks += *t->ccr + 1;
+			t->isr();
+			++fired;
+		}
+	}
+	return fired;
+}
+
+bool sim_timers_running(void)
+{
+	sim_timer_t *t;
+
+	for (t = timers; t < timers + countof(timers); t++) {
+		if (t->running)
+			return True;
+	}
+	return False;
+}
@@ -0,0 +1,37 @@
+/* Copyright (c) 2016 Kaan Mertol
+ * Licensed under the MIT License. See the accompanying LICENSE file */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include "types.h"
+
+/* The simulated hardware shared by the host tools, tools/replay and
+ * tools/energy:
+ * - sim_now is the virtual time in ns. Only the tool advances it, in its
+ *   sim_sleep, nothing advances while the host code runs.
+ * - The systimer's TA1(and TA2 with SYS_SLOW_DOMAIN) are followed through
+ *   their registers. sim_timers_poll picks up the starts and the stops, so
+ *   call it before asking for the next expiry. */
+
+#define SIM_ACLK_HZ 32768u
+#define SIM_NEVER   UINT64_MAX
+
+extern u64 sim_now;
+
+/* ACLK ticks to ns, rounded up so a timer never fires early */
+static inline u64 sim_ns(u64 ticks)
+{
+	return (ticks / SIM_ACLK_HZ) * 1000000000u
+	       + ((ticks % SIM_ACLK_HZ) * 1000000000u + SIM_ACLK_HZ - 1) / SIM_ACLK_HZ;
+}
+
+void sim_timers_poll(void);
+/* The time of the next expiry, SIM_NEVER if no timer runs */
+u64 sim_timers_next(void);
+/* Runs the ISRs of the timers that expired by sim_now, returns how many ran */
+uint sim_timers_fire(void);
+/* True while a timer runs, a timer on ACLK keeps ACLK requested even in LPM4 */
+bool sim_timers_running(void);
+
+#endif /* SIM_H */